@@ -31,6 +31,8 @@
 #define BOT_TOKEN ""
 
 Discord::Bot discord;
+ // The reply never changes, so it is rendered once in setup() and only copied when sent.
+Discord::PayloadTemplate<128> helloResponse;
 
 void on_discord_event(Discord::EventType type, const Discord::Event& data) {
     if (type != Discord::EventType::Ready) return;
@@ -45,22 +47,24 @@ void on_discord_event(Discord::EventType type, const Discord::Event& data) {
     cmd.description = "Ping the bot for a greeting.";
     cmd.default_member_permissions = 2147483648; //Use Application Commands
 
-    uint64_t id = Discord::Interactions::registerGlobalCommand(discord, cmd, BOT_TOKEN);
-    if (id == 0) {
-        Serial.println("Command registration failed!");
-    }
-    else {
-        Serial.print("Registered hello command to id ");
-        Serial.println(id);
+    // Registered on the REST task, so the Gateway keeps being serviced during the round trip.
+    bool scheduled = Discord::Interactions::registerGlobalCommandAsync(discord, cmd, BOT_TOKEN,
+        [](bool success, uint64_t id) {
+            if (!success) {
+                Serial.println("Command registration failed!");
+                return;
+            }
+            Serial.print("Registered hello command to id ");
+            Serial.println(id);
+        });
+    if (!scheduled) {
+        Serial.println("Command registration could not be scheduled!");
     }
 }
 
 void on_discord_interaction(const char* name, const JsonObject& interaction) {
     if (strcmp(name, "hello") == 0) {
-        Discord::Bot::MessageResponse response;
-        response.content = "Hello world!";
-        //response.flags = Discord::Bot::MessageResponse::Flags::EPHEMERAL;
-        discord.sendCommandResponse(Discord::Bot::InteractionResponse::CHANNEL_MESSAGE_WITH_SOURCE, response);
+        discord.sendCommandResponse(helloResponse);
     }
 }
 
@@ -82,6 +86,11 @@ void setup() {
     }
     Serial.println("\nWiFi connected. Connecting to Discord...");
 
+    Discord::Bot::MessageResponse response;
+    response.content = "Hello world!";
+    //response.flags = Discord::Bot::MessageResponse::Flags::EPHEMERAL;
+    Discord::Bot::prepareResponse(Discord::Bot::InteractionResponse::CHANNEL_MESSAGE_WITH_SOURCE, response, helloResponse);
+
     // Login with the provided bot token and no additional intent requirements.
     discord.login(BOT_TOKEN);
     // Optional: Set the interaction handling callback.
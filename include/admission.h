@@ -0,0 +1,91 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_ADMISSION_H_
+#define _DISCORD_ESP32A_ADMISSION_H_
+
+ // Below this much free heap in bytes, new interactions get the busy reply instead of the callback.
+#ifndef DISCORD_ADMISSION_MIN_HEAP
+#define DISCORD_ADMISSION_MIN_HEAP 24576
+#endif
+ // Below this much free heap or contiguous memory, not even the busy reply can be scheduled and interactions are
+ // dropped unanswered. The default fits one REST task's stack.
+#ifndef DISCORD_ADMISSION_DROP_BLOCK
+#define DISCORD_ADMISSION_DROP_BLOCK (4 * 1024 + 256 + 512)
+#endif
+ // From this many REST requests in flight, new interactions get the busy reply.
+#ifndef DISCORD_ADMISSION_MAX_REST_QUEUE
+#define DISCORD_ADMISSION_MAX_REST_QUEUE 6
+#endif
+ // From this many interaction responses waiting to be sent, new interactions get the busy reply.
+#ifndef DISCORD_ADMISSION_MAX_PENDING
+#define DISCORD_ADMISSION_MAX_PENDING 3
+#endif
+ // Message sent to users whose interaction was turned away. It is only visible to them.
+#ifndef DISCORD_BUSY_MESSAGE
+#define DISCORD_BUSY_MESSAGE "The bot is busy right now, please try again in a moment."
+#endif
+
+namespace Discord {
+    /*
+    Decides whether a new interaction is handled, turned away with a short "busy" reply, or dropped, based on how
+    much memory is left and how much REST work is already queued. The busy reply is a constant, so turning an
+    interaction away costs no more than the REST request that carries it.
+    */
+    class AdmissionController {
+    public:
+        enum class Decision : uint8_t {
+            Admit,
+            // Answer with the busy reply
+            Busy,
+            // Too little memory to answer at all
+            Drop
+        };
+
+        struct Pressure {
+            uint32_t freeHeap = UINT32_MAX;
+            uint32_t largestBlock = UINT32_MAX;
+            uint32_t restQueue = 0;
+            uint32_t pendingInteractions = 0;
+        };
+
+        struct Thresholds {
+            uint32_t minFreeHeap = DISCORD_ADMISSION_MIN_HEAP;
+            uint32_t dropBlock = DISCORD_ADMISSION_DROP_BLOCK;
+            uint32_t maxRestQueue = DISCORD_ADMISSION_MAX_REST_QUEUE;
+            uint32_t maxPendingInteractions = DISCORD_ADMISSION_MAX_PENDING;
+        };
+
+        Thresholds thresholds;
+        // Turns admission control off, every interaction is admitted.
+        bool enabled = true;
+
+        Decision decide(const Pressure& pressure) const;
+
+        /// @brief Reads the free heap and largest free block of the internal heap.
+        /// Hosts without one report no memory pressure.
+        static void sampleMemory(Pressure& pressure);
+
+        /// @brief The busy reply for an interaction type: a message, or an empty choice list for autocomplete.
+        static const char* busyResponse(uint8_t interactionType);
+    };
+}
+
+#endif //_DISCORD_ESP32A_ADMISSION_H_
@@ -0,0 +1,102 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_AUTOCOMPLETE_H_
+#define _DISCORD_ESP32A_AUTOCOMPLETE_H_
+
+ // Discord shows at most this many suggestions.
+#define DISCORD_AUTOCOMPLETE_MAX_CHOICES 25
+
+ // Size of the preallocated autocomplete response. Suggestions that do not fit are left out.
+#ifndef DISCORD_AUTOCOMPLETE_RESPONSE_SIZE
+#define DISCORD_AUTOCOMPLETE_RESPONSE_SIZE 1536
+#endif
+
+namespace Discord {
+    struct AutocompleteChoice {
+        // Shown to the user
+        const char* name;
+        // Sent back as the option's value once picked
+        const char* value;
+    };
+
+    /*
+    Builds an APPLICATION_COMMAND_AUTOCOMPLETE_RESULT response in place, without a JSON document.
+    The bot keeps one of these preallocated, see Bot::autocompleteResponse().
+    */
+    class AutocompleteResponse {
+    public:
+        AutocompleteResponse() { clear(); }
+
+        void clear();
+
+        /// @brief Adds a suggestion with a string value.
+        /// @return False if there are already 25 suggestions or the response is full.
+        bool add(const char* name, const char* value);
+
+        /// @brief Adds a suggestion with an integer value, for INTEGER options.
+        bool add(const char* name, long value);
+
+        bool add(const AutocompleteChoice& choice) { return add(choice.name, choice.value); }
+
+        /// @brief Adds suggestions until all are added or the response is full.
+        /// @return The number of suggestions added.
+        size_t add(const AutocompleteChoice* choices, size_t count);
+
+        size_t size() const { return _count; }
+
+        /// @brief The response payload.
+        const char* json();
+        size_t length() const { return _length + 3; }
+    private:
+        bool beginChoice(const char* name);
+        bool append(const char* str, size_t length);
+        bool appendEscaped(const char* str);
+
+        char _buffer[DISCORD_AUTOCOMPLETE_RESPONSE_SIZE];
+        size_t _length = 0;
+        size_t _count = 0;
+    };
+
+    /*
+    Prefix index over a static set of choices, for answering autocomplete without scanning or allocating.
+    The choices are sorted by name in place when the index is built, matches are then found with a binary search
+    and returned as a contiguous run of the array.
+    */
+    class AutocompleteIndex {
+    public:
+        /// @param choices The choice set, sorted in place. Must outlive the index.
+        /// @param count The number of choices.
+        AutocompleteIndex(AutocompleteChoice* choices, size_t count);
+
+        /// @brief Finds the choices whose names start with a prefix, ignoring ASCII case.
+        /// @param prefix What the user has typed so far. An empty prefix matches everything.
+        /// @param first Receives the first match.
+        /// @return The number of matches, which follow first in the array.
+        size_t match(const char* prefix, const AutocompleteChoice*& first) const;
+
+        size_t size() const { return _count; }
+    private:
+        AutocompleteChoice* _choices;
+        size_t _count;
+    };
+}
+
+#endif //_DISCORD_ESP32A_AUTOCOMPLETE_H_
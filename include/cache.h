@@ -0,0 +1,158 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "snowflake.h"
+
+#ifndef _DISCORD_ESP32A_CACHE_H_
+#define _DISCORD_ESP32A_CACHE_H_
+
+ // Cache capacities. Together with the string pool, these fix the cache's memory budget at compile time.
+#ifndef DISCORD_CACHE_GUILDS
+#define DISCORD_CACHE_GUILDS 4
+#endif
+#ifndef DISCORD_CACHE_CHANNELS
+#define DISCORD_CACHE_CHANNELS 64
+#endif
+#ifndef DISCORD_CACHE_ROLES
+#define DISCORD_CACHE_ROLES 64
+#endif
+ // Bytes shared by all interned names.
+#ifndef DISCORD_CACHE_STRING_POOL
+#define DISCORD_CACHE_STRING_POOL 2048
+#endif
+ // Names longer than this many bytes are truncated.
+#ifndef DISCORD_CACHE_NAME_LENGTH
+#define DISCORD_CACHE_NAME_LENGTH 31
+#endif
+ // Size of the JSON document used to parse GUILD_CREATE when a cache is attached.
+#ifndef DISCORD_CACHE_PARSE_SIZE
+#define DISCORD_CACHE_PARSE_SIZE 8192
+#endif
+
+namespace Discord {
+    /*
+    Compact guild, channel and role cache fed from Gateway dispatches.
+    Records live in arrays sorted by id for binary search lookups. Names are interned into a shared string pool.
+    When an array or the pool runs out of room, the least recently used records are evicted.
+    Attach one with Bot::setCache(), it does not allocate after construction.
+    */
+    class Cache {
+    public:
+        static const uint16_t NO_STRING = 0xFFFF;
+
+        struct Guild {
+            uint64_t id = 0;
+            uint32_t lastUsed = 0;
+            uint16_t name = NO_STRING;
+        };
+
+        struct Channel {
+            uint64_t id = 0;
+            uint64_t guildId = 0;
+            uint32_t lastUsed = 0;
+            uint16_t name = NO_STRING;
+            uint8_t type = 0;
+        };
+
+        struct Role {
+            uint64_t id = 0;
+            uint64_t guildId = 0;
+            uint64_t permissions = 0;
+            uint32_t color = 0;
+            uint32_t lastUsed = 0;
+            uint16_t name = NO_STRING;
+            int16_t position = 0;
+        };
+
+        Cache();
+
+        /// @brief Looks up a record by id. The pointer is valid until the cache is next updated.
+        /// @return The record, or nullptr if it is not cached.
+        const Guild* guild(uint64_t id);
+        const Channel* channel(uint64_t id);
+        const Role* role(uint64_t id);
+
+        /// @brief Resolves an interned name handle, such as Channel::name.
+        /// @return The name, or an empty string if it is not available.
+        const char* str(uint16_t handle) const;
+
+        /// @brief Combines the permissions of the @everyone role and the given roles of a guild.
+        /// Roles that are not cached are ignored.
+        uint64_t permissions(uint64_t guildId, const uint64_t* roleIds, size_t roleCount);
+
+        /// @brief Applies a Gateway dispatch to the cache.
+        /// @param type The dispatch type, the "t" field.
+        /// @param data The dispatch data, the "d" field.
+        /// @return True if the dispatch type is one the cache tracks.
+        bool update(const char* type, JsonObjectConst data);
+
+        /// @brief True if the dispatch type is one the cache tracks.
+        static bool tracks(const char* type);
+
+        void clear();
+
+        size_t guildCount() const { return _guildCount; }
+        size_t channelCount() const { return _channelCount; }
+        size_t roleCount() const { return _roleCount; }
+        size_t stringPoolUsed() const { return _poolUsed; }
+    private:
+        template <typename T, size_t N>
+        T* find(T (&records)[N], size_t count, uint64_t id);
+
+        template <typename T, size_t N>
+        T* insert(T (&records)[N], size_t& count, uint64_t id);
+
+        template <typename T, size_t N>
+        T* upsert(T (&records)[N], size_t& count, uint64_t id, const char* name);
+
+        template <typename T, size_t N>
+        void remove(T (&records)[N], size_t& count, uint64_t id);
+
+        template <typename T, size_t N>
+        size_t leastRecentlyUsed(T (&records)[N], size_t count);
+
+        uint16_t intern(const char* name);
+        void release(uint16_t handle);
+        void compact();
+        void remapHandle(uint16_t from, uint16_t to);
+        bool evictOne();
+
+        void updateGuild(JsonObjectConst data);
+        void updateChannel(uint64_t guildId, JsonObjectConst data);
+        void updateRole(uint64_t guildId, JsonObjectConst data);
+        void removeGuild(uint64_t id);
+
+        uint32_t _clock = 0;
+
+        Guild _guilds[DISCORD_CACHE_GUILDS];
+        Channel _channels[DISCORD_CACHE_CHANNELS];
+        Role _roles[DISCORD_CACHE_ROLES];
+        size_t _guildCount = 0;
+        size_t _channelCount = 0;
+        size_t _roleCount = 0;
+
+        // Entries are laid out as [reference count][length][characters][\0], handles are entry offsets.
+        uint8_t _pool[DISCORD_CACHE_STRING_POOL];
+        size_t _poolUsed = 0;
+    };
+}
+
+#endif //_DISCORD_ESP32A_CACHE_H_
@@ -0,0 +1,112 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "names.h"
+
+#ifndef _DISCORD_ESP32A_COMMANDS_H_
+#define _DISCORD_ESP32A_COMMANDS_H_
+
+ // Maximum number of prefix commands.
+#ifndef DISCORD_PREFIX_COMMANDS
+#define DISCORD_PREFIX_COMMANDS 16
+#endif
+
+ // Maximum number of arguments split out per command, further ones are only in Arguments::rest().
+#ifndef DISCORD_PREFIX_COMMAND_ARGS
+#define DISCORD_PREFIX_COMMAND_ARGS 8
+#endif
+
+namespace Discord {
+    /*
+    Text commands read from MESSAGE_CREATE, such as "!led on" or "!say \"hello world\"".
+    Messages starting with the prefix have the word right after it looked up in a hashed command table, and the
+    rest of the content split into arguments on whitespace, with double quotes grouping words. Arguments are views
+    into the message content as parsed from the frame, nothing is copied or allocated.
+    Attach one with Bot::setPrefixCommands(). Requires DISCORD_EVENTS_MESSAGES and the MESSAGE_CONTENT intent.
+    */
+    class PrefixCommands {
+    public:
+        // A piece of the message content. Not null-terminated.
+        struct Token {
+            const char* str = "";
+            size_t length = 0;
+
+            bool empty() const { return length == 0; }
+            bool equals(const char* other) const;
+
+            /// @brief Copies the token into a buffer and null-terminates it, truncating if needed.
+            /// @return The number of characters copied.
+            size_t copy(char* buffer, size_t size) const;
+        };
+
+        class Arguments {
+        public:
+            size_t size() const { return _count; }
+            // The argument at index, or an empty token past the end.
+            Token operator[](size_t index) const { return index < _count ? _values[index] : Token(); }
+            // Everything after the command name, untouched.
+            Token rest() const { return _rest; }
+            // True if there were more than DISCORD_PREFIX_COMMAND_ARGS arguments.
+            bool truncated() const { return _truncated; }
+        private:
+            friend class PrefixCommands;
+
+            Token _values[DISCORD_PREFIX_COMMAND_ARGS];
+            size_t _count = 0;
+            Token _rest;
+            bool _truncated = false;
+        };
+
+        /// @param args The arguments, only valid during the call.
+        /// @param message The message object, the "d" field of MESSAGE_CREATE. Holds at least id, channel_id,
+        /// guild_id, author and content.
+        typedef std::function<void(const Arguments& args, const JsonObject& message)> Handler;
+
+        /// @param prefix The command prefix, e.g. "!". Not copied, must outlive the table.
+        PrefixCommands(const char* prefix = "!");
+
+        /// @brief Registers a command, normally once at setup.
+        /// @param name The command name, without the prefix. Not copied, must outlive the table.
+        /// @param handler The function to call, from within the Gateway frame parse.
+        /// @return False if the table is full or the name is already taken.
+        bool add(const char* name, const Handler& handler);
+
+        /// @brief Calls the handler for the command in a message's content, if any.
+        /// @return False if the content does not start with the prefix or names no command.
+        bool dispatch(const char* content, const JsonObject& message) const;
+
+        size_t size() const { return _names.size(); }
+
+        /// @brief Splits text into arguments on whitespace. Double quotes group words into one argument
+        /// and are not part of it, an unterminated quote runs to the end of the text.
+        static void tokenize(const char* text, Arguments& out);
+    private:
+        const char* _prefix;
+        size_t _prefixLength;
+        HashedNames<DISCORD_PREFIX_COMMANDS> _names;
+        // Indexed like _names
+        Handler _handlers[DISCORD_PREFIX_COMMANDS];
+    };
+}
+
+#endif //_DISCORD_ESP32A_COMMANDS_H_
@@ -0,0 +1,76 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "names.h"
+
+#ifndef _DISCORD_ESP32A_COMPONENTS_H_
+#define _DISCORD_ESP32A_COMPONENTS_H_
+
+ // Maximum number of component routes.
+#ifndef DISCORD_COMPONENT_ROUTES
+#define DISCORD_COMPONENT_ROUTES 16
+#endif
+
+ // Separates the routed prefix of a custom_id from its argument, as in "relay:3".
+#ifndef DISCORD_COMPONENT_SEPARATOR
+#define DISCORD_COMPONENT_SEPARATOR ':'
+#endif
+
+namespace Discord {
+    /*
+    Routes message component and modal submit interactions by custom_id.
+    A custom_id of the form "prefix:argument" goes to the handler registered for "prefix", with "argument" passed
+    along; a custom_id without a separator is routed whole. Routes are hashed into a fixed table when added, so
+    dispatching is a hash and a compare however many routes there are.
+    */
+    class ComponentRouter {
+    public:
+        /// @param argument The part of the custom_id after the separator, or an empty string.
+        /// @param interaction The interaction object, the "d" field of INTERACTION_CREATE.
+        typedef std::function<void(const char* argument, const JsonObject& interaction)> Handler;
+
+        /// @brief Registers a handler, normally once at setup.
+        /// @param prefix The custom_id prefix, without the separator. Not copied, must outlive the router.
+        /// @param handler The function to call.
+        /// @return False if the table is full or the prefix is already routed.
+        bool add(const char* prefix, const Handler& handler);
+
+        /// @brief Calls the handler for a custom_id.
+        /// @return False if no route matches.
+        bool dispatch(const char* customId, const JsonObject& interaction) const;
+
+        size_t size() const { return _prefixes.size(); }
+
+        /// @brief Finds the value of a text input in a modal submit interaction.
+        /// @param interaction The interaction object.
+        /// @param customId The custom_id of the text input.
+        /// @return The value, or nullptr if the input is not part of the submission.
+        static const char* modalValue(const JsonObject& interaction, const char* customId);
+    private:
+        HashedNames<DISCORD_COMPONENT_ROUTES> _prefixes;
+        // Indexed like _prefixes
+        Handler _handlers[DISCORD_COMPONENT_ROUTES];
+    };
+}
+
+#endif //_DISCORD_ESP32A_COMPONENTS_H_
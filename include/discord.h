@@ -16,26 +16,110 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <mutex>
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <WebSocketsClient.h>
 
+#include "admission.h"
+#include "autocomplete.h"
+#include "cache.h"
+#include "commands.h"
+#include "components.h"
+#include "etf.h"
 #include "events.h"
+#include "intents.h"
+#include "members.h"
+#include "metrics.h"
+#include "payload.h"
+#include "placement.h"
+#include "recorder.h"
+#include "rest.h"
+#include "snowflake.h"
+#include "timers.h"
 
 #ifndef _DISCORD_ESP32A_H_
 #define _DISCORD_ESP32A_H_
 
 #define DISCORD_HOST "https://discord.com"
 #define DISCORD_API_URI "/api/v10"
+
+ // Define DISCORD_GATEWAY_ETF to receive Gateway frames as Erlang External Term Format instead of JSON.
+ // ETF frames are smaller and snowflakes arrive as integers, at the cost of converting outgoing payloads.
+#ifdef DISCORD_GATEWAY_ETF
+#define DISCORD_GATEWAY_SUFFIX "/?v=10&encoding=etf"
+#else
 #define DISCORD_GATEWAY_SUFFIX "/?v=10&encoding=json"
+#endif
+
+ // Size of the buffer outgoing Gateway payloads are encoded into in ETF mode.
+#ifndef DISCORD_ETF_SEND_BUFFER
+#define DISCORD_ETF_SEND_BUFFER 1024
+#endif
+
+ // Size of the pre-rendered Resume payload, which holds the bot token and session id.
+#ifndef DISCORD_RESUME_PAYLOAD_SIZE
+#define DISCORD_RESUME_PAYLOAD_SIZE 192
+#endif
 
  // Maximum number of events queued per frame, re-define and tweak this value if your bot polls slowly and misses them.
  // Using 2 because the dispatch event and its specific sub-events are both sent as one event each.
 #define DISCORD_MAX_EVENTS 2
 
+ // Lower bound in ms on how long to wait for a heartbeat ACK before treating the connection as zombied.
+#ifndef DISCORD_HEARTBEAT_ACK_MIN_TIMEOUT
+#define DISCORD_HEARTBEAT_ACK_MIN_TIMEOUT 5000
+#endif
+
+ // Time in ms a connection attempt may take from opening the socket to READY or RESUMED before it is retried.
+#ifndef DISCORD_HANDSHAKE_TIMEOUT
+#define DISCORD_HANDSHAKE_TIMEOUT 15000
+#endif
+
+ // Reconnect backoff window in ms after the first failed attempt, doubled per consecutive failure up to the maximum.
+#ifndef DISCORD_BACKOFF_BASE
+#define DISCORD_BACKOFF_BASE 1000
+#endif
+#ifndef DISCORD_BACKOFF_MAX
+#define DISCORD_BACKOFF_MAX 60000
+#endif
+
+ // Minimum time in ms between two presence updates. Requests made in between are coalesced into the latest one.
+#ifndef DISCORD_PRESENCE_INTERVAL
+#define DISCORD_PRESENCE_INTERVAL 12000
+#endif
+
+ // Gateway sends per rate window that presence updates leave untouched, so heartbeats always get through.
+#ifndef DISCORD_GATEWAY_RESERVE
+#define DISCORD_GATEWAY_RESERVE 5
+#endif
+
+ // Number of channels that can have queued message lines at once, and how long in ms lines are gathered.
+#ifndef DISCORD_MESSAGE_BATCH_SLOTS
+#define DISCORD_MESSAGE_BATCH_SLOTS 2
+#endif
+#ifndef DISCORD_MESSAGE_BATCH_WINDOW
+#define DISCORD_MESSAGE_BATCH_WINDOW 2000
+#endif
+
+ // Time in ms before retrying timed work that could not be done, such as a heartbeat the socket refused or
+ // a message batch held back by a rate limit.
+#ifndef DISCORD_TIMER_RETRY
+#define DISCORD_TIMER_RETRY 100
+#endif
+
+ // Time in ms an interaction token stays valid. Responses to older interactions are refused locally.
+#ifndef DISCORD_INTERACTION_TOKEN_LIFETIME
+#define DISCORD_INTERACTION_TOKEN_LIFETIME 900000
+#endif
+
+ // Define DISCORD_FAULT_INJECTION to build Bot::injectFault(), for timing recovery from Gateway faults on the bench.
+ // Stall in ms applied to each received frame by the SlowRead fault.
+#ifndef DISCORD_FAULT_SLOW_READ
+#define DISCORD_FAULT_SLOW_READ 500
+#endif
+
 namespace Discord {
     class Bot {
     public:
@@ -132,9 +216,44 @@ namespace Discord {
         //     const char* guildLocale = "";
         // };
 
+        enum class ConnectionState {
+            // Logged out, nothing happens until login() is called
+            Disconnected,
+            // Opening the WebSocket and waiting for Hello
+            Connecting,
+            // Identify sent, waiting for READY
+            Identifying,
+            // Connected and ready to receive events
+            Ready,
+            // Resume sent, waiting for RESUMED
+            Resuming,
+            // Waiting out the reconnect delay
+            Backoff
+        };
+
+        struct ReconnectStats {
+            // Connection attempts made, including the first one
+            uint32_t attempts = 0;
+            // Sessions resumed successfully
+            uint32_t resumes = 0;
+            // Fresh sessions established via Identify
+            uint32_t identifies = 0;
+            // Attempts that failed or timed out before READY or RESUMED
+            uint32_t failures = 0;
+            // Failures since the last READY or RESUMED, this drives the backoff
+            uint32_t consecutiveFailures = 0;
+            // Delay chosen for the most recent reconnect in ms
+            unsigned long lastBackoff = 0;
+            // Time from losing a ready connection to being ready again, in ms
+            unsigned long lastDowntime = 0;
+        };
+
         typedef std::function<void(EventType type, const Event& event)> EventCallback;
         typedef std::function<void(const char* name, const JsonObject& interaction)> InteractionCallback;
         //typedef std::function<void(const char* name, const Interaction& interaction)> InteractionCallback;
+        // option is the focused option being typed into, value what has been typed so far.
+        typedef std::function<void(const char* command, const char* option, const char* value,
+            const JsonObject& interaction)> AutocompleteCallback;
 
         struct AllowedMentions {
             // Controls user mentions
@@ -173,19 +292,77 @@ namespace Discord {
             Flags flags = Flags::NONE;
         };
 
+        struct Presence {
+            enum class Status : char {
+                ONLINE,
+                // Do Not Disturb
+                DND,
+                // AFK
+                IDLE,
+                // Invisible and shown as offline
+                INVISIBLE,
+                OFFLINE
+            };
+
+            enum class ActivityType : char {
+                // Playing {name}
+                GAME,
+                // Streaming {name}, requires url
+                STREAMING,
+                // Listening to {name}
+                LISTENING,
+                // Watching {name}
+                WATCHING,
+                // {emoji} {state}
+                CUSTOM,
+                // Competing in {name}
+                COMPETING
+            };
+
+            Status status = Status::ONLINE;
+            bool afk = false;
+            // Unix time in ms of when the client went idle, 0 if it is not idle.
+            uint64_t since = 0;
+
+            // Activity name, no activity is shown if empty. Not needed for ActivityType::CUSTOM.
+            const char* activityName = "";
+            ActivityType activityType = ActivityType::GAME;
+            // Custom status text, or the party status of other activities. A custom status is only shown if set.
+            const char* activityState = "";
+            // Stream URL, only used with ActivityType::STREAMING.
+            const char* activityUrl = "";
+        };
+
         Bot(bool rateLimit = true);
 
+        /// @brief Creates a bot that shares its HTTP connection and rate limits with other bots, such as the other
+        /// shards of the same application. The RestClient must outlive the bot.
+        Bot(RestClient& rest, bool rateLimit = true);
+
+        /// @brief Makes the bot connect as one shard of several, call before login().
+        /// Shards sharing a RestClient identify one at a time, DISCORD_IDENTIFY_INTERVAL apart.
+        /// @param shardId This shard's id, from 0 to shardCount - 1.
+        /// @param shardCount The total number of shards. 0 disables sharding.
+        void setShard(uint16_t shardId, uint16_t shardCount);
+
         /// @brief Connect to the Discord Gateway and login with the provided credentials.
         /// @param botToken The bot token obtained from the Discord Developer Portal.
-        /// @param intents The intents the bot needs to operate.
-        void login(const char* botToken, unsigned int intents = 0);
+        /// @param intents The intents the bot needs to operate, e.g. Intent::Guilds | Intent::GuildMessages.
+        void login(const char* botToken, Intents intents = Intents());
+
+        /// @brief Sets up REST calls without connecting to the Gateway, for bots that only receive interactions
+        /// through an InteractionsEndpoint. login() does this itself.
+        /// @param botToken The bot token obtained from the Discord Developer Portal.
+        void setToken(const char* botToken);
 
         /// @brief Runs state checks and event polls for the bot. This should be called even if the bot is offline.
-        void update();
+        /// @return Time in ms until the bot's next timer is due, or TimerWheel::NONE if none is scheduled.
+        /// Frames still arrive in between, so this bounds how long to sleep rather than how long to stop calling.
+        unsigned long update();
 
         /// @brief Runs state checks and event polls for the bot. This should be called even if the bot is offline.
         /// This version of the function allows you to pass a custom time value in ms.
-        void update(unsigned long now);
+        unsigned long update(unsigned long now);
 
         /// @brief Closes the Discord Gateway connection and logs out the bot.
         void logout();
@@ -214,76 +391,316 @@ namespace Discord {
         /// @param response The MessageResponse to send.
         void sendCommandResponse(const InteractionResponse& type, const MessageResponse& response);
 
-        //void updatePresence();
+        /// @brief Renders a message response into a template once, e.g. at setup, so that sending it is a copy.
+        /// Add slots by hand with text() and slot() if parts of it change per send.
+        /// @param type The type of response.
+        /// @param response The MessageResponse to render.
+        /// @param out The template to fill, cleared first.
+        /// @return False if the response does not fit in the template.
+        template <size_t N>
+        static bool prepareResponse(
+            const InteractionResponse& type, const MessageResponse& response, PayloadTemplate<N>& out);
+
+        /// @brief Sends a pre-rendered response to the current interaction.
+        /// @param response The template, see prepareResponse().
+        /// @param values One value per slot of the template, in order.
+        /// @param count The number of values.
+        template <size_t N>
+        bool sendCommandResponse(const PayloadTemplate<N>& response, const char* const* values = nullptr,
+            size_t count = 0);
+
+        /// @brief Sets the callback for autocomplete interactions, which can arrive once per keystroke.
+        /// Without one, autocomplete interactions go to the interaction callback like any other.
+        /// @param cb The callback function to use.
+        void onAutocomplete(const AutocompleteCallback& cb);
+
+        /// @brief The preallocated autocomplete response, cleared and ready to be filled.
+        /// Send it with sendAutocompleteResponse() from within the autocomplete callback.
+        AutocompleteResponse& autocompleteResponse();
+
+        /// @brief Answers the current autocomplete interaction with the preallocated response.
+        /// @return False if there is no interaction to answer or the request could not be scheduled.
+        bool sendAutocompleteResponse();
+
+        /// @brief Answers the current autocomplete interaction with a list of suggestions,
+        /// such as the matches from an AutocompleteIndex. At most 25 are sent.
+        bool sendAutocompleteResponse(const AutocompleteChoice* choices, size_t count);
+
+        /// @brief Routing table for message component and modal submit interactions, fill it at setup.
+        /// Routed interactions are answered like commands, e.g. with sendCommandResponse(UPDATE_MESSAGE, ...).
+        /// Interactions with no matching route go to the interaction callback, named by their custom_id.
+        ComponentRouter& components() { return _components; }
+
+        /// @brief Posts a message to a channel. The request runs asynchronously on the REST worker.
+        /// @param channelId The channel to post in.
+        /// @param message The message to send. EPHEMERAL has no effect outside of interactions.
+        /// @return False if the channel is currently rate limited or the request could not be scheduled.
+        bool createMessage(Snowflake channelId, const MessageResponse& message);
+
+        /// @brief Posts a message through a webhook. The request runs asynchronously on the REST worker.
+        /// @param webhookId The webhook's id, the first number in its URL.
+        /// @param webhookToken The webhook's token, the last part of its URL.
+        /// @param message The message to send.
+        /// @return False if the webhook is currently rate limited or the request could not be scheduled.
+        bool executeWebhook(Snowflake webhookId, const char* webhookToken, const MessageResponse& message);
+
+        /// @brief Queues a line of text for a channel. Lines queued within DISCORD_MESSAGE_BATCH_WINDOW ms of the
+        /// first one are joined into a single message, which is sent from update() once the channel is not rate
+        /// limited. Useful for alerts that tend to fire in bursts.
+        /// @param channelId The channel to post in.
+        /// @param line The text to add, copied immediately.
+        void queueMessage(Snowflake channelId, const char* line);
+
+        /// @brief Attaches a guild/channel/role cache, kept up to date from Gateway dispatches.
+        /// The cache is owned by the caller and must outlive the bot. Pass nullptr to detach it.
+        void setCache(Cache* cache) { _cache = cache; }
+        Cache* cache() { return _cache; }
+
+        /// @brief Attaches a prefix command table. Messages that start with its prefix are dispatched to their
+        /// command from within the frame parse, messages from bots are ignored. Requires DISCORD_EVENTS_MESSAGES
+        /// and the MESSAGE_CONTENT intent. The table is owned by the caller and must outlive the bot.
+        void setPrefixCommands(PrefixCommands* commands) { _prefixCommands = commands; }
+
+        /// @brief Attaches a flight recorder. Every Gateway frame received or sent is staged into it before it is
+        /// parsed or after it is sent, as the bytes that crossed the wire.
+        /// The recorder is owned by the caller and must outlive the bot. Pass nullptr to detach it.
+        void setRecorder(FlightRecorder* recorder) { _recorder = recorder; }
+        FlightRecorder* recorder() { return _recorder; }
+
+        /// @brief Updates the bot's presence. The update is sent from update() at most once per
+        /// DISCORD_PRESENCE_INTERVAL; if several arrive within that window, only the latest one is sent.
+        /// The strings are copied, so they do not need to outlive the call. The presence is re-applied after
+        /// a fresh session is established.
+        /// @param presence The presence to show.
+        void updatePresence(const Presence& presence);
+
+        /// @brief Asks the Gateway for the members of a guild (Request Guild Members, op 8). They arrive as
+        /// GUILD_MEMBERS_CHUNK dispatches, streamed one member at a time into the onGuildMember() callback.
+        /// Needs the GuildMembers intent when listing a whole guild.
+        /// @param guildId The guild to list.
+        /// @param query Only members whose username starts with this. Empty with limit 0 lists every member.
+        /// @param limit The maximum number of members, 0 for no limit.
+        /// @param nonce Echoed back in MembersChunk::nonce, up to 32 characters. May be nullptr.
+        /// @return False if the request could not be sent.
+        bool requestGuildMembers(Snowflake guildId, const char* query = "", uint16_t limit = 0,
+            const char* nonce = nullptr);
+
+        /// @brief Asks the Gateway for specific members of a guild, see above.
+        /// @param userIds The members to fetch, at most 100.
+        /// @param count The number of ids.
+        bool requestGuildMembers(Snowflake guildId, const Snowflake* userIds, size_t count,
+            const char* nonce = nullptr);
+
+        /// @brief Sets the callback members from GUILD_MEMBERS_CHUNK dispatches are streamed into.
+        /// Requires DISCORD_EVENTS_MEMBERS and the JSON Gateway encoding.
+        void onGuildMember(const GuildMemberCallback& cb) { _guildMemberCallback = cb; }
 
         bool online() { return _online; }
 
+        /// @brief Current state of the Gateway connection. update() drives all transitions.
+        ConnectionState state() const { return _state; }
+
+        /// @brief Counters describing reconnects and backoff since construction.
+        const ReconnectStats& reconnectStats() const { return _reconnectStats; }
+
+#ifdef DISCORD_FAULT_INJECTION
+        enum class Fault : uint8_t {
+            // Drops the Gateway connection, like a lost link
+            DropConnection,
+            // Feeds a Reconnect (op 7) through the frame parser
+            Reconnect,
+            // Feeds a non-resumable Invalid Session (op 9)
+            InvalidSession,
+            // Feeds a resumable Invalid Session (op 9, d true)
+            InvalidSessionResumable,
+            // Swallows the next <amount> heartbeat ACKs
+            MissHeartbeatAcks,
+            // Stalls the next <amount> received frames by DISCORD_FAULT_SLOW_READ ms each before they are parsed
+            SlowRead,
+            // Cuts the next <amount> received frames in half before they are parsed
+            PartialFrame
+        };
+
+        struct FaultReport {
+            Fault fault = Fault::DropConnection;
+            // millis() when the fault was injected
+            unsigned long injectedAt = 0;
+            // Set at the first READY or RESUMED after the fault. Stays false if the connection rode the fault out.
+            bool recovered = false;
+            // False if the session could not be resumed and everything dispatched in between was lost
+            bool resumed = false;
+            // Time from injection to READY or RESUMED in ms
+            unsigned long recoveryTime = 0;
+            // Dispatches missed since the fault, from gaps in the sequence numbers
+            uint32_t missedEvents = 0;
+        };
+
+        /// @brief Injects a fault into the Gateway connection to exercise the recovery paths and time them.
+        /// Protocol faults are fed through the same parser as frames from Discord. Requires DISCORD_FAULT_INJECTION.
+        /// @param fault The fault to inject.
+        /// @param amount How many heartbeat ACKs or frames a lasting fault affects, ignored by the others.
+        void injectFault(Fault fault, uint32_t amount = 1);
+
+        /// @brief How the bot recovered from the most recently injected fault.
+        const FaultReport& lastFault() const { return _faultReport; }
+#endif
+
+        /// @brief Smoothed heartbeat round-trip time (send to HEARTBEAT_ACK) in ms, or 0 before the first ACK.
+        unsigned long heartbeatRTT() const { return _heartbeatRTT; }
+
         const uint64_t& applicationId() const { return _applicationId; }
+
+        /// @brief Latency histograms, counters and queue gauges recorded by the bot.
+        /// Use Metrics::snapshot() or Metrics::exportText() to read them.
+        Metrics& metrics() { return _metrics; }
+        const Metrics& metrics() const { return _metrics; }
+
+        /// @brief Decides which interactions are handled under memory or queue pressure. Interactions turned away
+        /// get a busy reply or are dropped before reaching any callback, see admission.h.
+        AdmissionController& admission() { return _admission; }
     private:
+        friend class InteractionsEndpoint;
+
         template <size_t sz>
         struct AsyncAPIRequest {
             AsyncAPIRequest(
                 HTTPClient& httpClient,
                 const char* method,
-                const String& uri,
+                const char* uri,
                 const String& json = "",
                 const char* authorisationToken = "",
                 std::function<void(const StaticJsonDocument<sz>& json)> cb = nullptr,
-                std::mutex* mtx = nullptr);
+                RestScheduler* scheduler = nullptr,
+                Metrics* metrics = nullptr);
 
             HTTPClient& client;
             const char* method;
-            const String uri = "";
+            char uri[DISCORD_URL_LENGTH];
             const String json = "";
             const char* authorisationToken = "";
             std::function<void(const StaticJsonDocument<sz>& json)> callback;
-            std::mutex* clientMtx = nullptr;
+            RestScheduler* scheduler = nullptr;
+            unsigned long deadline = 0;
+            RestPriority priority = RestPriority::Bulk;
+            Metrics* metrics = nullptr;
+            // Connection the request goes out on, also tracks the rate limit of rateLimitKey if any
+            RestClient* rest = nullptr;
+            uint64_t rateLimitKey = 0;
+            // Called instead of the callback when the request fails, with the HTTP code or HTTPClient error
+            std::function<void(int code)> failure;
+        };
+
+        struct MessageBatch {
+            uint64_t channelId = 0;
+            // Fires DISCORD_MESSAGE_BATCH_WINDOW after the first line was queued
+            TimerWheel::Timer timer;
+            String content;
         };
 
         void onWebSocketEvents(WStype_t type, uint8_t* payload, size_t length);
         void pushEvent(Event const& event);
         void pushEvent(EventType type);
-        void parseMessage(uint8_t* payload, size_t length);
+        Metrics::Frame parseMessage(uint8_t* payload, size_t length);
 
-        void heartbeat();
+        // False if the heartbeat could not be sent.
+        bool heartbeat();
+        void stopHeartbeat();
         void identify();
+        void prepareIdentify();
+        void sendPresence();
         void resume();
+        void prepareResume();
+        void connect();
+        void scheduleReconnect(bool resume, unsigned long delay);
+        void connectionEstablished(bool resumed);
+        void setState(ConnectionState state);
+        unsigned long backoffDelay() const;
+        unsigned long heartbeatAckTimeout() const;
 
         bool sendWS(const char* payload, size_t length);
 
         bool sendRest(
             const char* method,
-            const String& uri,
+            const char* uri,
             const String& json = "",
             const char* authorisationToken = "");
         
         template <size_t sz>
         bool sendRest(
             const char* method,
-            const String& uri,
+            const char* uri,
             const String& json = "",
             const char* authorisationToken = "",
             StaticJsonDocument<sz>* responseDoc = nullptr);
         
         template <size_t sz>
-        void sendPostAsync(
+        bool sendPostAsync(
             const char* method,
-            const String& uri,
+            const char* uri,
             const String& json,
             const char* authorisationToken,
             std::function<void(const StaticJsonDocument<sz>& json)> cb,
-            std::mutex* mtx);
+            RestScheduler* scheduler,
+            uint64_t rateLimitKey = 0,
+            RestPriority priority = RestPriority::Bulk,
+            std::function<void(int code)> failure = nullptr);
+
+        // Top-level fields of a JSON Gateway frame, found without deserializing it.
+        struct FrameHead {
+            int op = -1;
+            bool hasSequence = false;
+            unsigned int s = 0;
+            // Points into the payload, not null-terminated
+            const char* t = nullptr;
+            size_t tLength = 0;
+        };
+
+        bool postInteractionCallback(const String& json);
+        void handleInteraction(JsonObject interaction, unsigned long receivedAt);
+        bool admitInteraction(uint8_t type);
+        // Runs the handlers for an interaction received over HTTP. False if none of them responded.
+        bool answerEndpointInteraction(JsonObject interaction, unsigned long receivedAt, String& response);
+        void dispatchAutocomplete(JsonObject interaction);
+
+        static bool containsToken(const uint8_t* payload, size_t length, const char* token);
+        static bool scanFrameHead(const uint8_t* payload, size_t length, FrameHead& head);
+        // Stages a frame into the recorder, if one is attached. json is the frame as JSON text, to find its op.
+        void recordFrame(FlightRecorder::Direction direction, const uint8_t* wire, size_t wireLength,
+            const uint8_t* json, size_t jsonLength);
+        // Handles a frame from its head when its data is not needed. False if it needs a full parse.
+        bool parseFrameHead(const FrameHead& head, uint8_t* payload, size_t length, unsigned long receivedAt,
+            Metrics::Frame& frame);
+        void heartbeatAcknowledged(unsigned long receivedAt);
+        // Advances the sequence number, counting the dispatches skipped over.
+        void trackSequence(unsigned int sequence);
+        void sessionResumed();
+        Metrics::Frame messageCreated(JsonObject message);
+        bool skipDispatch(EventType type) const;
+        JsonDocument& guildCreateFilter();
+        JsonDocument& readyFilter();
+        static void serializeMessage(const MessageResponse& response, JsonObject data);
+        bool flushMessageBatch(MessageBatch& batch);
 
         template <size_t sz>
         static void sendPostTask(void* parameter);
 
-        std::mutex _httpsMtx;
-        HTTPClient _https;
+        RestClient _ownRest;
+        RestClient* _rest;
+        HTTPClient& _https;
+        RestScheduler& _restScheduler;
         WebSocketsClient _socket;
         EventCallback _outerCallback;
         InteractionCallback _interactionCallback;
+        AutocompleteCallback _autocompleteCallback;
+        GuildMemberCallback _guildMemberCallback;
+        AutocompleteResponse _autocompleteSlot;
+        ComponentRouter _components;
+        AdmissionController _admission;
+        // Set while an endpoint interaction is being handled, receives its response
+        String* _endpointResponse = nullptr;
 
         String _gatewayURL;
+        String _resumeURL;
 
         Event _eventQueue[DISCORD_MAX_EVENTS];
         size_t _eventQueueIndex;
@@ -293,28 +710,92 @@ namespace Discord {
         const char* _t = "t";
         const char* _botToken = nullptr;
         uint64_t _applicationId = 0;
-        unsigned int _intents = 0;
+        Intents _intents;
 
         uint64_t _interactionId;
         String _interactionToken;
+        // millis() at which the frame carrying the current interaction arrived
+        unsigned long _interactionReceivedAt = 0;
 
         bool _online = false;
 
+        enum class PendingReconnect : uint8_t {
+            None,
+            // Reconnect straight away and resume the session
+            Resume,
+            // Reconnect after a short random wait with a fresh session
+            Identify,
+            // The connection dropped, back off before resuming
+            Failure
+        };
+
+        ConnectionState _state = ConnectionState::Disconnected;
+        PendingReconnect _pendingReconnect = PendingReconnect::None;
+        unsigned long _disconnectedAt = 0;
+        ReconnectStats _reconnectStats;
+
         unsigned long _now;
         unsigned long _heartbeatInterval = 0;
-        unsigned long _lastHeartbeatAck = 0;
-        unsigned long _lastHeartbeatSend = 0;
-        unsigned long _firstHeartbeat = 0;
+        // millis() at which the last heartbeat left, for round-trip measurement
+        unsigned long _heartbeatSentAt = 0;
+        unsigned long _heartbeatRTT = 0;
+        unsigned long _heartbeatRTTVar = 0;
 
         bool _ready = false;
+        uint16_t _shardId = 0;
+        uint16_t _shardCount = 0;
+        // Hello arrived, waiting for the shared Identify slot
+        bool _identifyQueued = false;
         String _sessionId;
+        // Rendered Identify and Resume payloads, rebuilt when the token, intents, shard or session change
+        String _identifyPayload;
+        PayloadTemplate<DISCORD_RESUME_PAYLOAD_SIZE> _resumePayload;
         // You need to cache the most recent non-null sequence value for heartbeats, and to pass when resuming a connection.
         unsigned int _lastSocketSequence = 0;
 
+#ifdef DISCORD_FAULT_INJECTION
+        void injectFrame(const char* json);
+        void applyReadFaults(size_t& length);
+
+        FaultReport _faultReport;
+        uint32_t _acksToMiss = 0;
+        uint32_t _slowReads = 0;
+        uint32_t _partialFrames = 0;
+#endif
+
         // Rate limiting
         bool _rateLimit = true;
         unsigned short _eventsSent = 0;
-        unsigned long _lastRateReset = 0;
+
+        // Latest requested presence as a ready-to-send op 3 frame
+        String _presencePayload;
+        bool _presencePending = false;
+
+        // Every timed action of the bot runs off this wheel.
+        TimerWheel _timers;
+        // Due when the next heartbeat should go out
+        TimerWheel::Timer _heartbeatTimer;
+        // Armed while a heartbeat waits for its ACK, fires when the connection is considered zombied
+        TimerWheel::Timer _heartbeatAckTimer;
+        // Opens a new Gateway send rate window
+        TimerWheel::Timer _rateResetTimer;
+        // Armed from opening the socket until READY or RESUMED
+        TimerWheel::Timer _handshakeTimer;
+        // Ends the wait before reconnecting
+        TimerWheel::Timer _backoffTimer;
+        // Armed for DISCORD_PRESENCE_INTERVAL after a presence update is sent
+        TimerWheel::Timer _presenceTimer;
+        // Retries claiming an Identify slot held by another shard
+        TimerWheel::Timer _identifyTimer;
+        // Expires the current interaction's token
+        TimerWheel::Timer _interactionTimer;
+
+        Metrics _metrics;
+        Cache* _cache = nullptr;
+        FlightRecorder* _recorder = nullptr;
+        PrefixCommands* _prefixCommands = nullptr;
+
+        MessageBatch _messageBatches[DISCORD_MESSAGE_BATCH_SLOTS];
 
         friend class Interactions;
     };
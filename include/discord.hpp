@@ -25,10 +25,12 @@ namespace Discord {
     template<size_t sz>
     inline bool Bot::sendRest(
         const char* method,
-        const String& uri,
+        const char* uri,
         const String& json,
         const char* authorisationToken,
         StaticJsonDocument<sz>* responseDoc) {
+        RestTurn turn(_restScheduler, RestScheduler::deadline(RestPriority::Bulk, millis()), RestPriority::Bulk);
+        if (turn.missedDeadline()) _metrics.increment(Metrics::Counter::RestDeadlinesMissed);
 
         _https.setURL(uri);
 
@@ -42,6 +44,9 @@ namespace Discord {
         }
 
         Serial.println("SEnD REQUEST");
+        // Opened separately so the round trip below does not include a handshake.
+        _rest->connect(&_metrics);
+        unsigned long start = millis();
         int httpResponseCode = 0;
         if (!json.isEmpty()) {
             httpResponseCode = _https.sendRequest(method, json);
@@ -50,9 +55,10 @@ namespace Discord {
         else {
             httpResponseCode = _https.sendRequest(method);
         }
+        _metrics.restRoundTrip(Metrics::classify(uri)).record(millis() - start);
 #ifdef _DISCORD_CLIENT_DEBUG
 #ifdef ESP32
-        log_d("[DISCORD] Sent %s request to %s", method, uri.c_str());
+        log_d("[DISCORD] Sent %s request to %s", method, uri);
 #else
         Serial.print(method);
         Serial.print(" request to ");
@@ -71,6 +77,7 @@ namespace Discord {
 #endif
             if (httpResponseCode == HTTP_CODE_UNAUTHORIZED) {
                 Serial.println("[DISCORD] 401 Not Authorised.");
+                _metrics.increment(Metrics::Counter::RestRequestsFailed);
                 return false;
             }
             if (httpResponseCode != HTTP_CODE_NO_CONTENT) { //204 no content
@@ -102,66 +109,123 @@ namespace Discord {
         }
 
         // Request failed
+        _metrics.increment(Metrics::Counter::RestRequestsFailed);
         Serial.print("[DISCORD] Error code: ");
         Serial.println(httpResponseCode);
         return false;
     }
 
+    template<size_t N>
+    bool Bot::prepareResponse(const InteractionResponse& type, const MessageResponse& response, PayloadTemplate<N>& out) {
+        StaticJsonDocument<512> doc;
+        doc["type"] = static_cast<unsigned short>(type);
+        serializeMessage(response, doc.createNestedObject("data"));
+
+        out.clear();
+        char rendered[N];
+        size_t length = serializeJson(doc, rendered, N);
+        // A full buffer means the output was cut short.
+        if (doc.overflowed() || length >= N - 1) return false;
+        out.text(rendered, length);
+        return !out.overflowed();
+    }
+
+    template<size_t N>
+    bool Bot::sendCommandResponse(const PayloadTemplate<N>& response, const char* const* values, size_t count) {
+        if (_interactionId == 0 || _interactionToken.isEmpty()) {
+#ifdef ESP32
+            log_e("[DISCORD] [COMMAND] No token or id available!");
+#else
+            Serial.println("[DISCORD] [COMMAND] No token or id available!");
+#endif
+            return false;
+        }
+        String json((char*)0);
+        response.render(json, values, count);
+        return postInteractionCallback(json);
+    }
+
     template<size_t sz>
     Bot::AsyncAPIRequest<sz>::AsyncAPIRequest(
         HTTPClient& httpClient,
         const char* method,
-        const String& uri,
+        const char* uri,
         const String& json,
         const char* authorisationToken,
         std::function<void(const StaticJsonDocument<sz>& json)> cb,
-        std::mutex* mtx) :
+        RestScheduler* scheduler,
+        Metrics* metrics) :
         client { httpClient },
         method { method },
-        uri { uri },
         json { json },
         authorisationToken { authorisationToken },
         callback { cb },
-        clientMtx { mtx } {}
+        scheduler { scheduler },
+        metrics { metrics } {
+        strncpy(this->uri, uri, DISCORD_URL_LENGTH - 1);
+        this->uri[DISCORD_URL_LENGTH - 1] = '\0';
+    }
 
     template<size_t sz>
-    void Bot::sendPostAsync(
+    bool Bot::sendPostAsync(
         const char* method,
-        const String& uri,
+        const char* uri,
         const String& json,
         const char* authorisationToken,
         std::function<void(const StaticJsonDocument<sz>& json)> cb,
-        std::mutex* mtx) {
+        RestScheduler* scheduler,
+        uint64_t rateLimitKey,
+        RestPriority priority,
+        std::function<void(int code)> failure) {
 
         AsyncAPIRequest<sz>* request = new AsyncAPIRequest<sz>(
-            _https, method, uri, json, authorisationToken, std::move(cb), mtx);
+            _https, method, uri, json, authorisationToken, std::move(cb), scheduler, &_metrics);
+        request->rest = _rest;
+        request->rateLimitKey = rateLimitKey;
+        request->priority = priority;
+        request->failure = std::move(failure);
+        // Interaction responses are due relative to when the interaction arrived, not when the reply was ready.
+        request->deadline = RestScheduler::deadline(
+            priority, priority == RestPriority::Interaction ? _interactionReceivedAt : millis());
 
         TaskHandle_t task = nullptr;
+        _metrics.adjustGauge(Metrics::Gauge::RestQueueDepth, 1);
+        if (priority == RestPriority::Interaction) _metrics.adjustGauge(Metrics::Gauge::PendingInteractions, 1);
         // Task priority of 2 will ensure the post request gets sent first within the 3s window.
         // IIRC, this also avoids the scheduler from switching back and forth, avoiding race conditions.
-        xTaskCreate(
+        if (xTaskCreate(
             sendPostTask<sz>,
             "DiscordSendPostTask",
             4 * 1024 + sz,
             static_cast<void*>(request),
-            tskIDLE_PRIORITY + 2, &task);
+            tskIDLE_PRIORITY + 2, &task) != pdPASS) {
+            Serial.println("[DISCORD] Not enough memory to schedule the request, dropping it.");
+            _metrics.adjustGauge(Metrics::Gauge::RestQueueDepth, -1);
+            if (priority == RestPriority::Interaction) {
+                _metrics.adjustGauge(Metrics::Gauge::PendingInteractions, -1);
+            }
+            _metrics.increment(Metrics::Counter::RestRequestsDropped);
+            delete request;
+            return false;
+        }
 
 #ifdef _DISCORD_CLIENT_DEBUG
         Serial.print("Async task created with ");
         Serial.print(4 * 1024 + sz);
         Serial.println(" bytes of stack allocated.");
 #endif
+        return true;
     }
 
     template<size_t sz>
     void Bot::sendPostTask(void* parameter) {
         AsyncAPIRequest<sz>* request = static_cast<AsyncAPIRequest<sz>*>(parameter);
 
-        // Lock the HttpClient via the provided mutex if needed to avoid race conditions on multiple tasks.
-        // std::unique_lock<std::mutex> lock = (request->clientMtx == nullptr) ?
-        //     std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(*request->clientMtx);
-        if (request->clientMtx) {
-            request->clientMtx->lock();
+        // Wait for our turn on the HttpClient if needed to avoid race conditions on multiple tasks.
+        // Requests due soonest go first, whatever order they were scheduled in.
+        if (request->scheduler && request->scheduler->acquire(request->deadline, request->priority) &&
+            request->metrics) {
+            request->metrics->increment(Metrics::Counter::RestDeadlinesMissed);
         }
 
         request->client.setURL(request->uri);
@@ -176,22 +240,45 @@ namespace Discord {
         }
 
 #ifdef _DISCORD_CLIENT_DEBUG
-        if (!request->json.isEmpty()) {
+        if (!request->json.isEmpty() || strcmp(request->method, "DELETE") == 0 ||
+            strcmp(request->method, "GET") == 0) {
 #endif
-            httpResponseCode = request->client.POST(request->json);
+            if (request->rest) {
+                request->rest->connect(request->metrics);
+            }
+            unsigned long start = millis();
+            httpResponseCode = request->json.isEmpty() ?
+                request->client.sendRequest(request->method) :
+                request->client.sendRequest(request->method, request->json);
+            if (request->metrics) {
+                request->metrics->restRoundTrip(Metrics::classify(request->uri)).record(millis() - start);
+            }
+            if (request->rest && request->rateLimitKey != 0 && httpResponseCode > 0) {
+                request->rest->updateRateLimit(request->rateLimitKey, httpResponseCode);
+            }
 #ifdef _DISCORD_CLIENT_DEBUG
         }
         else {
             // Request failed
             Serial.print("[DISCORD] No payload to POST with!");
-            if (request->clientMtx) {
-                request->clientMtx->unlock();
+            if (request->scheduler) {
+                request->scheduler->release();
+            }
+            if (request->metrics) {
+                request->metrics->adjustGauge(Metrics::Gauge::RestQueueDepth, -1);
+                if (request->priority == RestPriority::Interaction) {
+                    request->metrics->adjustGauge(Metrics::Gauge::PendingInteractions, -1);
+                }
+                request->metrics->increment(Metrics::Counter::RestRequestsFailed);
+            }
+            if (request->failure) {
+                request->failure(0);
             }
             delete request;
             vTaskDelete(nullptr);
         }
 #ifdef ESP32
-        log_d("[DISCORD] Sent %s request to %s", request->method, request->uri.c_str());
+        log_d("[DISCORD] Sent %s request to %s", request->method, request->uri);
 #else
         Serial.print(request->method);
         Serial.print(" request to ");
@@ -211,6 +298,7 @@ namespace Discord {
             Serial.println(httpResponseCode);
 #endif
 #endif
+            bool failed = true;
             if (httpResponseCode == HTTP_CODE_BAD_REQUEST) {
                 Serial.print("[DISCORD] 400 Bad Request: ");
                 Serial.println(request->client.getString());
@@ -218,9 +306,19 @@ namespace Discord {
             else if (httpResponseCode == HTTP_CODE_UNAUTHORIZED) {
                 Serial.println("[DISCORD] 401 Not Authorised.");
             }
-            else if (request->callback != nullptr) {
-                StaticJsonDocument<sz> response;
+            else if (httpResponseCode >= 400) {
+                Serial.print("[DISCORD] Request failed with HTTP code ");
+                Serial.println(httpResponseCode);
+            }
+            else {
+                failed = false;
+            }
 
+            StaticJsonDocument<sz> response;
+            if (failed) {
+                if (request->metrics) request->metrics->increment(Metrics::Counter::RestRequestsFailed);
+            }
+            else if (request->callback != nullptr) {
                 // Here we pass getString instead of getStream. While ArduinoJson recommends against this,
                 // this allows us to keep the benefits of HTTP 1.1+, since Discord's payloads are usually small.
                 if (httpResponseCode != HTTP_CODE_NO_CONTENT) {
@@ -236,21 +334,43 @@ namespace Discord {
                         Serial.println(e.c_str());
                     }
                 }
-                request->callback(response);
             }
-            if (request->clientMtx) {
-                request->clientMtx->unlock();
+            // Give up the connection before running user code, which may well make a REST call of its own.
+            if (request->scheduler) {
+                request->scheduler->release();
+            }
+            if (request->metrics) {
+                request->metrics->adjustGauge(Metrics::Gauge::RestQueueDepth, -1);
+                if (request->priority == RestPriority::Interaction) {
+                    request->metrics->adjustGauge(Metrics::Gauge::PendingInteractions, -1);
+                }
+            }
+            if (failed) {
+                if (request->failure) request->failure(httpResponseCode);
+            }
+            else if (request->callback != nullptr) {
+                request->callback(response);
             }
             delete request;
             vTaskDelete(nullptr);
         }
 
         // Request failed
-        if (request->clientMtx) {
-            request->clientMtx->unlock();
+        if (request->scheduler) {
+            request->scheduler->release();
+        }
+        if (request->metrics) {
+            request->metrics->adjustGauge(Metrics::Gauge::RestQueueDepth, -1);
+            if (request->priority == RestPriority::Interaction) {
+                request->metrics->adjustGauge(Metrics::Gauge::PendingInteractions, -1);
+            }
+            request->metrics->increment(Metrics::Counter::RestRequestsFailed);
         }
         Serial.print("[DISCORD] Error code: ");
         Serial.println(httpResponseCode);
+        if (request->failure) {
+            request->failure(httpResponseCode);
+        }
         delete request;
         vTaskDelete(nullptr);
     }
@@ -0,0 +1,75 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#ifndef _DISCORD_ESP32A_ENDPOINT_H_
+#define _DISCORD_ESP32A_ENDPOINT_H_
+
+ // Largest interaction payload accepted by the endpoint, in bytes. Larger requests are refused unverified.
+#ifndef DISCORD_ENDPOINT_MAX_BODY
+#define DISCORD_ENDPOINT_MAX_BODY 4096
+#endif
+
+namespace Discord {
+    class Bot;
+
+    /*
+    Receives interactions through Discord's interactions endpoint URL instead of the Gateway.
+    Discord POSTs each interaction to the endpoint, signed with the application's Ed25519 key. Verified
+    interactions go to the bot's usual interaction, autocomplete and component handlers, and the response they
+    send is returned in the HTTP response body rather than through a separate REST call.
+
+    The server speaks plain HTTP. Discord only calls HTTPS URLs, so put it behind a TLS-terminating proxy or
+    tunnel. The bot does not need to log in to the Gateway to use this, but REST calls still need its token,
+    see Bot::setToken().
+    */
+    class InteractionsEndpoint {
+    public:
+        /// @param bot The bot whose handlers answer the interactions.
+        /// @param port The port to listen on.
+        /// @param path The URL path Discord posts to.
+        InteractionsEndpoint(Bot& bot, uint16_t port = 80, const char* path = "/interactions");
+
+        /// @brief Starts listening.
+        /// @param publicKey The application's public key from the developer portal, as 64 hex digits.
+        /// @return False if the key is malformed.
+        bool begin(const char* publicKey);
+
+        void stop();
+
+        /// @brief Serves pending requests. Call this from the loop, like Bot::update().
+        void update();
+    private:
+        void handleRequest();
+        bool verify(const String& signature, const String& timestamp, const String& body);
+
+        static bool decodeHex(const char* hex, size_t length, uint8_t* out);
+
+        Bot& _bot;
+        WebServer _server;
+        const char* _path;
+        uint8_t _publicKey[32];
+        bool _started = false;
+        // The signed message is the timestamp followed by the body.
+        uint8_t _message[DISCORD_ENDPOINT_MAX_BODY + 32];
+    };
+}
+
+#endif //_DISCORD_ESP32A_ENDPOINT_H_
@@ -0,0 +1,59 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef _DISCORD_ESP32A_ETF_H_
+#define _DISCORD_ESP32A_ETF_H_
+
+ // Maximum nesting of lists, tuples and maps accepted by the ETF decoder.
+#ifndef DISCORD_ETF_NESTING_LIMIT
+#define DISCORD_ETF_NESTING_LIMIT 16
+#endif
+
+namespace Discord {
+    /*
+    Erlang External Term Format (ETF) support for the Gateway's encoding=etf mode.
+    Decoded terms land in a JsonDocument shaped exactly like the JSON encoding would give:
+    maps become objects, lists and tuples arrays, binaries strings, the atoms nil/true/false null and booleans, and
+    64-bit integers (snowflakes) decimal strings.
+    */
+
+    /// @brief Decodes an ETF payload into a JsonDocument.
+    /// Like ArduinoJson's zero-copy mode, strings are terminated in place and referenced rather than copied, so the
+    /// input is modified and must outlive the document.
+    /// @param doc The document to fill.
+    /// @param data The payload, starting with the version byte 131.
+    /// @param length The payload size in bytes.
+    /// @return Ok, or the reason decoding stopped.
+    DeserializationError deserializeEtf(JsonDocument& doc, uint8_t* data, size_t length);
+
+    /// @brief Decodes the parts of an ETF payload selected by a filter, with the same rules as
+    /// DeserializationOption::Filter.
+    DeserializationError deserializeEtf(JsonDocument& doc, uint8_t* data, size_t length, JsonVariantConst filter);
+
+    /// @brief Encodes a JSON value as an ETF payload.
+    /// @param source The value to encode.
+    /// @param buffer The destination.
+    /// @param size The size of the destination in bytes.
+    /// @return The number of bytes written, or 0 if the buffer is too small.
+    size_t serializeEtf(JsonVariantConst source, uint8_t* buffer, size_t size);
+}
+
+#endif //_DISCORD_ESP32A_ETF_H_
@@ -16,9 +16,31 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <Arduino.h>
+
 #ifndef _DISCORD_ESP32A_EVENTS_H_
 #define _DISCORD_ESP32A_EVENTS_H_
 
+ // Dispatch event families, see DISCORD_EVENT_FAMILIES.
+#define DISCORD_EVENTS_INTERACTIONS 0x001
+#define DISCORD_EVENTS_MESSAGES 0x002
+#define DISCORD_EVENTS_REACTIONS 0x004
+#define DISCORD_EVENTS_GUILDS 0x008
+#define DISCORD_EVENTS_CHANNELS 0x010
+#define DISCORD_EVENTS_MEMBERS 0x020
+#define DISCORD_EVENTS_MODERATION 0x040
+#define DISCORD_EVENTS_PRESENCE 0x080
+#define DISCORD_EVENTS_OTHER 0x100
+#define DISCORD_EVENTS_ALL 0x1FF
+
+ // The dispatch event families the application handles, as an OR of DISCORD_EVENTS_* flags.
+ // Dispatches from other families are recognised by their type and skipped before they are deserialized,
+ // and the library's handling code for them is compiled out. READY and RESUMED are always handled.
+ // The cache needs DISCORD_EVENTS_GUILDS and DISCORD_EVENTS_CHANNELS.
+#ifndef DISCORD_EVENT_FAMILIES
+#define DISCORD_EVENT_FAMILIES DISCORD_EVENTS_ALL
+#endif
+
 namespace Discord {
     enum class EventType {
         Dispatch,
@@ -108,6 +130,34 @@ namespace Discord {
     union Event {
         EventType type;
     };
+
+    enum class EventFamily : uint16_t {
+        // READY, RESUMED and the non-dispatch opcodes
+        Lifecycle = 0,
+        Interactions = DISCORD_EVENTS_INTERACTIONS,
+        Messages = DISCORD_EVENTS_MESSAGES,
+        Reactions = DISCORD_EVENTS_REACTIONS,
+        Guilds = DISCORD_EVENTS_GUILDS,
+        Channels = DISCORD_EVENTS_CHANNELS,
+        Members = DISCORD_EVENTS_MEMBERS,
+        Moderation = DISCORD_EVENTS_MODERATION,
+        Presence = DISCORD_EVENTS_PRESENCE,
+        Other = DISCORD_EVENTS_OTHER
+    };
+
+    /// @brief True if the family is enabled in DISCORD_EVENT_FAMILIES. Branches on this fold away at compile time.
+    constexpr bool subscribed(EventFamily family) {
+        return family == EventFamily::Lifecycle || (DISCORD_EVENT_FAMILIES & static_cast<uint16_t>(family)) != 0;
+    }
+
+    /// @brief The family an event belongs to.
+    EventFamily eventFamily(EventType type);
+
+    /// @brief Maps a dispatch type name, the "t" field, to its event.
+    /// @param name The type name, does not need to be null-terminated.
+    /// @param length The length of the name.
+    /// @return The event, or EventType::Dispatch if the type is unknown.
+    EventType dispatchEventType(const char* name, size_t length);
 }
 
 #endif //_DISCORD_ESP32A_EVENTS_H_
@@ -0,0 +1,70 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_INTENTS_H_
+#define _DISCORD_ESP32A_INTENTS_H_
+
+namespace Discord {
+    /*
+    Gateway intents, the event groups Discord sends to a connection. Combine them with |:
+    discord.login(token, Discord::Intent::Guilds | Discord::Intent::GuildMessages);
+    */
+    enum class Intent : uint32_t {
+        Guilds = 1UL << 0,
+        // Privileged
+        GuildMembers = 1UL << 1,
+        GuildModeration = 1UL << 2,
+        GuildEmojisAndStickers = 1UL << 3,
+        GuildIntegrations = 1UL << 4,
+        GuildWebhooks = 1UL << 5,
+        GuildInvites = 1UL << 6,
+        GuildVoiceStates = 1UL << 7,
+        // Privileged
+        GuildPresences = 1UL << 8,
+        GuildMessages = 1UL << 9,
+        GuildMessageReactions = 1UL << 10,
+        GuildMessageTyping = 1UL << 11,
+        DirectMessages = 1UL << 12,
+        DirectMessageReactions = 1UL << 13,
+        DirectMessageTyping = 1UL << 14,
+        // Privileged
+        MessageContent = 1UL << 15,
+        GuildScheduledEvents = 1UL << 16,
+        AutoModerationConfiguration = 1UL << 20,
+        AutoModerationExecution = 1UL << 21
+    };
+
+    /*
+    A set of intents. Converts from the raw bit field for compatibility with plain integers.
+    */
+    struct Intents {
+        uint32_t value;
+
+        constexpr Intents(uint32_t bits = 0) : value { bits } {}
+        constexpr Intents(Intent intent) : value { static_cast<uint32_t>(intent) } {}
+
+        constexpr Intents operator|(Intents other) const { return Intents(value | other.value); }
+        constexpr bool has(Intent intent) const { return (value & static_cast<uint32_t>(intent)) != 0; }
+    };
+
+    constexpr Intents operator|(Intent a, Intent b) { return Intents(a) | Intents(b); }
+}
+
+#endif //_DISCORD_ESP32A_INTENTS_H_
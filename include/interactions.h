@@ -16,10 +16,14 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <functional>
+
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 
+#include "snowflake.h"
+
 #ifndef _DISCORD_ESP32A_INTERACTIONS_H_
 #define _DISCORD_ESP32A_INTERACTIONS_H_
 
@@ -83,6 +87,12 @@ namespace Discord {
             bool nsfw = false;
         };
 
+        /// @brief Completion callback of the asynchronous command functions. Runs on the REST task after it has
+        /// released the connection, so it may make REST calls of its own.
+        /// @param success True if Discord accepted the request.
+        /// @param commandId The id of the registered or deleted command, 0 if a registration failed.
+        typedef std::function<void(bool success, uint64_t commandId)> CommandCallback;
+
         /// @brief Registers a global command for the bot.
         /// @param applicationId Your bot's application ID, found on the developer portal.
         /// @param command Details of the command.
@@ -98,13 +108,47 @@ namespace Discord {
         /// @param botToken The bot's token, used for authentication.
         /// @return The id of the command if it returned successfully, or an empty string if it failed.
         static uint64_t registerGuildCommand(
-            Bot& bot, const char* guildId, const ApplicationCommand& command, const char* botToken);
+            Bot& bot, Snowflake guildId, const ApplicationCommand& command, const char* botToken);
+
+        /// @brief Deletes a global command of the bot.
+        /// @param commandId The id returned when the command was registered.
+        /// @param botToken The bot's token, used for authentication.
+        /// @return True if the command was deleted.
+        static bool deleteGlobalCommand(Bot& bot, Snowflake commandId, const char* botToken);
 
-        static bool deleteGlobalCommand(Bot& bot, const String& commandId, const char* botToken);
+        /// @brief Deletes a guild command of the bot.
+        /// @param guildId The guild the command was registered to.
+        /// @param commandId The id returned when the command was registered.
+        /// @param botToken The bot's token, used for authentication.
+        /// @return True if the command was deleted.
         static bool deleteGuildCommand(
-            Bot& bot, const char* guildId, const String& commandId, const char* botToken);
+            Bot& bot, Snowflake guildId, Snowflake commandId, const char* botToken);
+
+        /// @brief Registers a global command on the REST task instead of blocking the caller, so several
+        /// registrations can be in flight while update() keeps the Gateway serviced.
+        /// @param command Details of the command, serialized before returning.
+        /// @param botToken The bot's token, must stay valid until the callback has run.
+        /// @param cb Called once the request completes or fails.
+        /// @return True if the request was scheduled. The callback is not called otherwise.
+        static bool registerGlobalCommandAsync(
+            Bot& bot, const ApplicationCommand& command, const char* botToken, CommandCallback cb = nullptr);
+
+        /// @brief Registers a guild command on the REST task, see registerGlobalCommandAsync().
+        static bool registerGuildCommandAsync(Bot& bot, Snowflake guildId, const ApplicationCommand& command,
+            const char* botToken, CommandCallback cb = nullptr);
+
+        /// @brief Deletes a global command on the REST task, see registerGlobalCommandAsync().
+        static bool deleteGlobalCommandAsync(
+            Bot& bot, Snowflake commandId, const char* botToken, CommandCallback cb = nullptr);
+
+        /// @brief Deletes a guild command on the REST task, see registerGlobalCommandAsync().
+        static bool deleteGuildCommandAsync(
+            Bot& bot, Snowflake guildId, Snowflake commandId, const char* botToken, CommandCallback cb = nullptr);
 
         static bool serializeCommand(const ApplicationCommand& command, StaticJsonDocument<1024>& doc);
+    private:
+        static bool sendAsync(Bot& bot, const char* method, const char* uri, const String& json,
+            const char* botToken, uint64_t commandId, CommandCallback cb);
     };
 }
 
@@ -0,0 +1,70 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <functional>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "snowflake.h"
+
+#ifndef _DISCORD_ESP32A_MEMBERS_H_
+#define _DISCORD_ESP32A_MEMBERS_H_
+
+ // Size of the document each member of a GUILD_MEMBERS_CHUNK is parsed into, one member at a time.
+ // Members that do not fit are skipped and counted in MembersChunk::skipped.
+#ifndef DISCORD_MEMBER_PARSE_SIZE
+#define DISCORD_MEMBER_PARSE_SIZE 1536
+#endif
+
+ // Maximum length of a Request Guild Members nonce, as set by Discord.
+#define DISCORD_MEMBERS_NONCE_LENGTH 32
+
+namespace Discord {
+    /*
+    Where a member streamed out of a GUILD_MEMBERS_CHUNK came from.
+    */
+    struct MembersChunk {
+        Snowflake guildId;
+        uint16_t index = 0;
+        uint16_t count = 0;
+        // The nonce given to Bot::requestGuildMembers(), empty if none
+        char nonce[DISCORD_MEMBERS_NONCE_LENGTH + 1] = {};
+        // Members passed to the callback so far
+        uint16_t members = 0;
+        // Members that did not fit in DISCORD_MEMBER_PARSE_SIZE
+        uint16_t skipped = 0;
+    };
+
+    /// @param chunk The chunk the member is from.
+    /// @param member A guild member object, valid for the duration of the call.
+    typedef std::function<void(const MembersChunk& chunk, JsonObjectConst member)> GuildMemberCallback;
+
+    /// @brief Streams the members of a GUILD_MEMBERS_CHUNK frame into a callback, one member at a time.
+    /// The frame is walked in place and each member parsed into a fixed-size document, so memory use does not
+    /// depend on the size of the chunk. The payload is not modified.
+    /// @param payload The whole JSON Gateway frame.
+    /// @param length The frame's length in bytes.
+    /// @param chunk Filled with the chunk's guild, index, count and nonce before the first member.
+    /// @param callback Called once per member.
+    /// @return False if the frame has no members array or is malformed.
+    bool streamMembersChunk(const uint8_t* payload, size_t length, MembersChunk& chunk,
+        const GuildMemberCallback& callback);
+}
+
+#endif //_DISCORD_ESP32A_MEMBERS_H_
@@ -0,0 +1,201 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_METRICS_H_
+#define _DISCORD_ESP32A_METRICS_H_
+
+// Number of buckets per histogram, including the overflow bucket. Bucket bounds follow a 1-2-5 series.
+#define DISCORD_METRICS_BUCKETS 13
+
+namespace Discord {
+    /*
+    Allocation-free instrumentation for the bot. Every value is held in fixed-size atomics, so recording is safe
+    from the gateway loop and the async REST tasks alike.
+
+    Text export format (one record per line, space separated):
+        h <name> <count> <sum> <max> <bucket 0> ... <bucket N>
+        c <name> <value>
+        g <name> <current> <highest>
+    Bucket i counts samples <= Metrics::bucketBound(i), the last bucket counts everything above.
+    Histogram sums wrap at 2^32 units, so take deltas between scrapes.
+    */
+    class Metrics {
+    public:
+        // REST routes tracked separately for round-trip time.
+        enum class Route : uint8_t {
+            Gateway,
+            InteractionCallback,
+            ApplicationCommands,
+            ChannelMessages,
+            Webhooks,
+            Other,
+            COUNT
+        };
+
+        // Gateway frame families tracked separately for parse time.
+        enum class Frame : uint8_t {
+            Control,
+            Ready,
+            Interaction,
+            Message,
+            Dispatch,
+            COUNT
+        };
+
+        enum class Counter : uint8_t {
+            // Events discarded because the event queue was full
+            EventsDropped,
+            // Gateway sends refused by the rate limiter or the socket
+            GatewaySendsDropped,
+            // Async REST requests that could not be scheduled
+            RestRequestsDropped,
+            // REST requests that returned an error or no response
+            RestRequestsFailed,
+            // Gateway frames that failed to deserialize
+            FramesDiscarded,
+            // Presence updates replaced by a newer one before they were sent
+            PresenceUpdatesCoalesced,
+            // Dispatches skipped unparsed because their event family is not in DISCORD_EVENT_FAMILIES
+            DispatchesSkipped,
+            // Gateway frames handled from their op, s and t without a full deserialize
+            FramesParsedLazily,
+            // Interactions endpoint requests refused for a missing or invalid signature
+            EndpointRequestsRejected,
+            // REST requests that had to open a new TLS connection
+            TlsHandshakes,
+            // REST requests sent over an already open connection
+            RestConnectionsReused,
+            // Interactions passed on to the callbacks by the admission controller
+            InteractionsAdmitted,
+            // Interactions answered with the busy reply
+            InteractionsShed,
+            // Interactions left unanswered for lack of memory
+            InteractionsDropped,
+            // REST requests that got the connection after their deadline
+            RestDeadlinesMissed,
+            // Dispatches never received, from gaps in the Gateway sequence numbers
+            EventsMissed,
+            // Sessions that could not be resumed and were replaced by a fresh Identify
+            SessionsLost,
+            COUNT
+        };
+
+        enum class Gauge : uint8_t {
+            EventQueueDepth,
+            RestQueueDepth,
+            // Interaction responses scheduled but not sent yet
+            PendingInteractions,
+            COUNT
+        };
+
+        class Histogram {
+        public:
+            struct Snapshot {
+                uint32_t count = 0;
+                uint32_t sum = 0;
+                uint32_t max = 0;
+                uint32_t buckets[DISCORD_METRICS_BUCKETS] = {};
+            };
+
+            Histogram();
+
+            void record(uint32_t value);
+            void snapshot(Snapshot& out) const;
+            void reset();
+        private:
+            std::atomic<uint32_t> _count;
+            std::atomic<uint32_t> _sum;
+            std::atomic<uint32_t> _max;
+            std::atomic<uint32_t> _buckets[DISCORD_METRICS_BUCKETS];
+        };
+
+        struct Snapshot {
+            // Interaction receive to response sent, in ms
+            Histogram::Snapshot interactionLatency;
+            // REST round-trip time per route, in ms
+            Histogram::Snapshot restRoundTrip[static_cast<size_t>(Route::COUNT)];
+            // Gateway frame parse time per frame family, in us
+            Histogram::Snapshot parseTime[static_cast<size_t>(Frame::COUNT)];
+            // Heartbeat send to HEARTBEAT_ACK, in ms
+            Histogram::Snapshot heartbeatRoundTrip;
+            // TCP connect and TLS handshake of the REST connection, in ms
+            Histogram::Snapshot tlsHandshake;
+            // Losing a ready Gateway connection to READY or RESUMED again, in ms
+            Histogram::Snapshot recoveryTime;
+            uint32_t counters[static_cast<size_t>(Counter::COUNT)] = {};
+            uint32_t gauges[static_cast<size_t>(Gauge::COUNT)] = {};
+            uint32_t gaugeHighs[static_cast<size_t>(Gauge::COUNT)] = {};
+        };
+
+        Metrics();
+
+        Histogram& interactionLatency() { return _interactionLatency; }
+        Histogram& restRoundTrip(Route route) { return _restRoundTrip[static_cast<size_t>(route)]; }
+        Histogram& parseTime(Frame frame) { return _parseTime[static_cast<size_t>(frame)]; }
+        Histogram& heartbeatRoundTrip() { return _heartbeatRoundTrip; }
+        Histogram& tlsHandshake() { return _tlsHandshake; }
+        Histogram& recoveryTime() { return _recoveryTime; }
+
+        void increment(Counter counter, uint32_t amount = 1);
+        void setGauge(Gauge gauge, uint32_t value);
+        void adjustGauge(Gauge gauge, int32_t delta);
+        uint32_t gauge(Gauge gauge) const;
+
+        /// @brief Copies every metric into a plain struct. Values are read individually, not as one atomic unit.
+        /// @param out The snapshot to fill.
+        void snapshot(Snapshot& out) const;
+
+        /// @brief Resets every histogram and counter. Gauges keep their current value but lose their high mark.
+        void reset();
+
+        /// @brief Writes the metrics in the compact text format described above.
+        /// @param out Any Print stream, such as Serial or a WiFiClient.
+        void exportText(Print& out) const;
+
+        /// @brief Writes the metrics in the compact text format into a buffer.
+        /// @param buffer The destination, always null-terminated when size > 0.
+        /// @param size The size of the destination in bytes.
+        /// @return The length the full export needs, excluding the terminator, like snprintf.
+        size_t exportText(char* buffer, size_t size) const;
+
+        /// @brief Upper bound of a histogram bucket. The last bucket has no bound and returns UINT32_MAX.
+        static uint32_t bucketBound(size_t bucket);
+
+        /// @brief Maps a REST URI onto the route it is accounted under.
+        static Route classify(const char* uri);
+    private:
+        template <typename Writer>
+        void writeText(Writer& writer) const;
+
+        Histogram _interactionLatency;
+        Histogram _restRoundTrip[static_cast<size_t>(Route::COUNT)];
+        Histogram _parseTime[static_cast<size_t>(Frame::COUNT)];
+        Histogram _heartbeatRoundTrip;
+        Histogram _tlsHandshake;
+        Histogram _recoveryTime;
+        std::atomic<uint32_t> _counters[static_cast<size_t>(Counter::COUNT)];
+        std::atomic<uint32_t> _gauges[static_cast<size_t>(Gauge::COUNT)];
+        std::atomic<uint32_t> _gaugeHighs[static_cast<size_t>(Gauge::COUNT)];
+    };
+}
+
+#endif //_DISCORD_ESP32A_METRICS_H_
@@ -0,0 +1,91 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_NAMES_H_
+#define _DISCORD_ESP32A_NAMES_H_
+
+namespace Discord {
+    /*
+    Fixed table of up to N names, hashed for lookups by a name that need not be null-terminated. Names get indices
+    0 to N - 1 in the order they were added, so callers keep what belongs to a name in an array of their own.
+    Lookups are a hash, usually one probe and a compare. Used by ComponentRouter and PrefixCommands.
+    */
+    template <size_t N>
+    class HashedNames {
+    public:
+        static_assert(N < 0xFF, "Name indices are stored in a byte");
+
+        HashedNames() { memset(_slots, EMPTY, sizeof(_slots)); }
+
+        /// @brief Adds a name.
+        /// @param name Not copied, must outlive the table.
+        /// @return The name's index, or -1 if the table is full or the name is already in it.
+        int add(const char* name) {
+            if (!name || _count >= N) return -1;
+            size_t length = strlen(name);
+            if (find(name, length) >= 0) return -1;
+
+            _names[_count] = name;
+            _lengths[_count] = length;
+            // The table is never more than half full, so an empty slot always turns up.
+            size_t i = hash(name, length) % SLOTS;
+            while (_slots[i] != EMPTY) {
+                i = (i + 1) % SLOTS;
+            }
+            _slots[i] = _count;
+            return _count++;
+        }
+
+        /// @brief Looks up a name.
+        /// @param name The characters to match, not necessarily null-terminated.
+        /// @param length The number of characters.
+        /// @return The name's index, or -1 if it was not added.
+        int find(const char* name, size_t length) const {
+            for (size_t i = hash(name, length) % SLOTS, probes = 0; probes < SLOTS; i = (i + 1) % SLOTS, ++probes) {
+                uint8_t index = _slots[i];
+                if (index == EMPTY) return -1;
+                if (_lengths[index] == length && memcmp(_names[index], name, length) == 0) return index;
+            }
+            return -1;
+        }
+
+        size_t size() const { return _count; }
+    private:
+        static const size_t SLOTS = N * 2;
+        static const uint8_t EMPTY = 0xFF;
+
+        static uint32_t hash(const char* str, size_t length) {
+            // FNV-1a
+            uint32_t h = 2166136261UL;
+            for (size_t i = 0; i < length; ++i) {
+                h = (h ^ static_cast<uint8_t>(str[i])) * 16777619UL;
+            }
+            return h;
+        }
+
+        const char* _names[N];
+        size_t _lengths[N];
+        size_t _count = 0;
+        // Open addressing with linear probing, holds indices into _names.
+        uint8_t _slots[SLOTS];
+    };
+}
+
+#endif //_DISCORD_ESP32A_NAMES_H_
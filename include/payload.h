@@ -0,0 +1,193 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_PAYLOAD_H_
+#define _DISCORD_ESP32A_PAYLOAD_H_
+
+ // Default size of a payload template's fixed text.
+#ifndef DISCORD_PAYLOAD_TEMPLATE_SIZE
+#define DISCORD_PAYLOAD_TEMPLATE_SIZE 512
+#endif
+ // Maximum number of slots per template.
+#ifndef DISCORD_PAYLOAD_TEMPLATE_SLOTS
+#define DISCORD_PAYLOAD_TEMPLATE_SLOTS 4
+#endif
+
+namespace Discord {
+    /*
+    A JSON payload rendered once, with a few slots filled in at send time.
+    Build it at setup from text() and slot(), then render() it for each send: the fixed text is copied as is, so a
+    send costs a memcpy plus the slot values. Appending past the end sets overflowed() instead of writing out of
+    bounds, like UrlBuilder.
+
+        PayloadTemplate<64> greeting;
+        greeting.text("{\"type\":4,\"data\":{\"content\":\"Hello ").slot(SlotType::String).text("!\"}}");
+    */
+    enum class SlotType : uint8_t {
+        // Inserted verbatim: numbers, booleans, null or ready-made JSON
+        Raw,
+        // Escaped as the inside of a JSON string, the quotes belong to the surrounding text
+        String
+    };
+
+    template <size_t N = DISCORD_PAYLOAD_TEMPLATE_SIZE>
+    class PayloadTemplate {
+    public:
+        PayloadTemplate() { _text[0] = '\0'; }
+        PayloadTemplate(const char* text) : PayloadTemplate() { this->text(text); }
+
+        PayloadTemplate& text(const char* str) { return text(str, strlen(str)); }
+
+        PayloadTemplate& text(const char* str, size_t length) {
+            if (_length + length >= N) {
+                _overflowed = true;
+                return *this;
+            }
+            memcpy(_text + _length, str, length);
+            _length += length;
+            _text[_length] = '\0';
+            return *this;
+        }
+
+        PayloadTemplate& slot(SlotType type = SlotType::Raw) {
+            if (_slotCount == DISCORD_PAYLOAD_TEMPLATE_SLOTS) {
+                _overflowed = true;
+                return *this;
+            }
+            _slots[_slotCount].offset = _length;
+            _slots[_slotCount].type = type;
+            ++_slotCount;
+            return *this;
+        }
+
+        void clear() {
+            _text[0] = '\0';
+            _length = 0;
+            _slotCount = 0;
+            _overflowed = false;
+        }
+
+        /// @brief Renders the payload into a buffer.
+        /// @param buffer The destination, always null-terminated when size > 0.
+        /// @param size The size of the destination in bytes.
+        /// @param values One value per slot, in order. Missing or null values render as nothing.
+        /// @param count The number of values.
+        /// @return The length the full payload needs, excluding the terminator, like snprintf.
+        size_t render(char* buffer, size_t size, const char* const* values = nullptr, size_t count = 0) const {
+            BufferWriter writer { buffer, size, 0 };
+            write(writer, values, count);
+            if (size > 0) {
+                buffer[writer.length < size ? writer.length : size - 1] = '\0';
+            }
+            return writer.length;
+        }
+
+        /// @brief Appends the rendered payload to a String.
+        void render(String& out, const char* const* values = nullptr, size_t count = 0) const {
+            out.reserve(out.length() + _length + (_slotCount > 0 ? 32 : 0));
+            StringWriter writer { out };
+            write(writer, values, count);
+        }
+
+        /// @brief The fixed text, which is the whole payload when there are no slots.
+        const char* c_str() const { return _text; }
+        size_t length() const { return _length; }
+        size_t slotCount() const { return _slotCount; }
+        bool overflowed() const { return _overflowed; }
+    private:
+        struct Slot {
+            uint16_t offset = 0;
+            SlotType type = SlotType::Raw;
+        };
+
+        struct BufferWriter {
+            char* buffer;
+            size_t size;
+            size_t length;
+
+            void operator()(const char* str, size_t n) {
+                if (length < size) {
+                    size_t room = size - length - 1;
+                    memcpy(buffer + length, str, n < room ? n : room);
+                }
+                length += n;
+            }
+        };
+
+        struct StringWriter {
+            ::String& out;
+
+            void operator()(const char* str, size_t n) { out.concat(str, n); }
+        };
+
+        template <typename Writer>
+        void write(Writer& writer, const char* const* values, size_t count) const {
+            size_t from = 0;
+            for (size_t i = 0; i < _slotCount; ++i) {
+                writer(_text + from, _slots[i].offset - from);
+                from = _slots[i].offset;
+                const char* value = values && i < count ? values[i] : nullptr;
+                if (!value) continue;
+                if (_slots[i].type == SlotType::Raw) {
+                    writer(value, strlen(value));
+                }
+                else {
+                    writeEscaped(writer, value);
+                }
+            }
+            writer(_text + from, _length - from);
+        }
+
+        template <typename Writer>
+        static void writeEscaped(Writer& writer, const char* value) {
+            // Write runs of plain characters in one go, escapes one at a time.
+            const char* run = value;
+            for (const char* c = value; *c; ++c) {
+                uint8_t ch = static_cast<uint8_t>(*c);
+                if (ch >= 0x20 && ch != '"' && ch != '\\') continue;
+                writer(run, c - run);
+                run = c + 1;
+                char escape[7] = { '\\', static_cast<char>(ch), 0 };
+                size_t length = 2;
+                switch (ch) {
+                    case '\n': escape[1] = 'n'; break;
+                    case '\r': escape[1] = 'r'; break;
+                    case '\t': escape[1] = 't'; break;
+                    case '"':
+                    case '\\':
+                        break;
+                    default:
+                        length = snprintf(escape, sizeof(escape), "\\u%04x", ch);
+                        break;
+                }
+                writer(escape, length);
+            }
+            writer(run, strlen(run));
+        }
+
+        char _text[N];
+        size_t _length = 0;
+        Slot _slots[DISCORD_PAYLOAD_TEMPLATE_SLOTS];
+        size_t _slotCount = 0;
+        bool _overflowed = false;
+    };
+}
+
+#endif //_DISCORD_ESP32A_PAYLOAD_H_
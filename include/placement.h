@@ -0,0 +1,134 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <new>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef _DISCORD_ESP32A_PLACEMENT_H_
+#define _DISCORD_ESP32A_PLACEMENT_H_
+
+ // Where the library's heap buffers go by default, one of the DISCORD_PLACEMENT_* values below.
+ // Can be changed at runtime with setPlacement().
+#define DISCORD_PLACEMENT_INTERNAL 0
+#define DISCORD_PLACEMENT_COLD_IN_PSRAM 1
+#define DISCORD_PLACEMENT_ALL_IN_PSRAM 2
+#ifndef DISCORD_PLACEMENT
+#define DISCORD_PLACEMENT DISCORD_PLACEMENT_INTERNAL
+#endif
+
+namespace Discord {
+    /*
+    Placement of the library's larger heap buffers between internal SRAM and PSRAM.
+    Internal SRAM is fast but scarce, PSRAM on WROVER-class boards is plentiful but several times slower to access
+    and unusable for task stacks. The policy decides per kind of buffer; allocations fall back to internal SRAM when
+    PSRAM is absent or full.
+    Every allocation carries a small header recording its size and region, which feeds the per-region statistics.
+    On hosts without heap_caps, allocations come from malloc and are only tagged with the region the policy chose,
+    so the statistics can be checked off-target.
+    */
+    enum class MemoryRegion : uint8_t {
+        Internal,
+        Psram,
+        COUNT
+    };
+
+    enum class BufferKind : uint8_t {
+        // The document each Gateway frame is parsed into, touched on every frame
+        GatewayFrame,
+        // Documents for rare, large payloads: filtered GUILD_CREATE, outgoing ETF re-encoding
+        LargeFrame,
+        // Long-lived tables such as a Cache, touched on lookups
+        Cache,
+        COUNT
+    };
+
+    enum class Placement : uint8_t {
+        // Everything in internal SRAM
+        Internal = DISCORD_PLACEMENT_INTERNAL,
+        // Large and cold buffers in PSRAM, per-frame buffers in internal SRAM
+        ColdInPsram = DISCORD_PLACEMENT_COLD_IN_PSRAM,
+        // Everything in PSRAM, for when internal SRAM is the bottleneck
+        AllInPsram = DISCORD_PLACEMENT_ALL_IN_PSRAM
+    };
+
+    struct MemoryStats {
+        // Bytes currently allocated, headers included
+        uint32_t bytes = 0;
+        uint32_t highest = 0;
+        uint32_t allocations = 0;
+        // Allocations that wanted PSRAM but got internal SRAM
+        uint32_t fallbacks = 0;
+    };
+
+    void setPlacement(Placement placement);
+    Placement placement();
+
+    /// @brief The region the current policy puts a kind of buffer in.
+    MemoryRegion preferredRegion(BufferKind kind);
+
+    /// @brief Allocates a buffer according to the placement policy.
+    /// @return The buffer, or nullptr if no region has room.
+    void* allocate(size_t size, BufferKind kind);
+
+    /// @brief Resizes a buffer from allocate(), keeping its kind. The contents are preserved up to the smaller size.
+    void* reallocate(void* ptr, size_t size, BufferKind kind);
+
+    /// @brief Frees a buffer from allocate(). Null is ignored.
+    void release(void* ptr);
+
+    /// @brief The region a buffer from allocate() ended up in.
+    MemoryRegion regionOf(const void* ptr);
+
+    /// @brief Allocation statistics of a region since startup.
+    MemoryStats memoryStats(MemoryRegion region);
+
+    /*
+    ArduinoJson allocator placing a document's pool by buffer kind:
+        PlacedJsonDocument doc(8192, PlacedAllocator(BufferKind::LargeFrame));
+    */
+    struct PlacedAllocator {
+        BufferKind kind;
+
+        PlacedAllocator(BufferKind kind = BufferKind::LargeFrame) : kind { kind } {}
+
+        void* allocate(size_t size) { return Discord::allocate(size, kind); }
+        void deallocate(void* ptr) { Discord::release(ptr); }
+        void* reallocate(void* ptr, size_t size) { return Discord::reallocate(ptr, size, kind); }
+    };
+
+    typedef BasicJsonDocument<PlacedAllocator> PlacedJsonDocument;
+
+    /// @brief Constructs an object, such as a Cache, in the region its kind is placed in.
+    /// Destroy it with destroy().
+    template <typename T>
+    T* create(BufferKind kind = BufferKind::Cache) {
+        void* memory = allocate(sizeof(T), kind);
+        return memory ? new (memory) T() : nullptr;
+    }
+
+    template <typename T>
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        release(object);
+    }
+}
+
+#endif //_DISCORD_ESP32A_PLACEMENT_H_
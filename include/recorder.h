@@ -0,0 +1,165 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <mutex>
+
+#include <Arduino.h>
+#include <FS.h>
+
+#ifndef _DISCORD_ESP32A_RECORDER_H_
+#define _DISCORD_ESP32A_RECORDER_H_
+
+ // Bytes of RAM records are staged in until the background task writes them out.
+#ifndef DISCORD_RECORDER_BUFFER
+#define DISCORD_RECORDER_BUFFER 4096
+#endif
+ // Payload bytes kept per record, longer frames are truncated.
+#ifndef DISCORD_RECORDER_MAX_PAYLOAD
+#define DISCORD_RECORDER_MAX_PAYLOAD 1024
+#endif
+ // Time in ms between background flushes. A flush also starts once the staging buffer is half full.
+#ifndef DISCORD_RECORDER_FLUSH_INTERVAL
+#define DISCORD_RECORDER_FLUSH_INTERVAL 2000
+#endif
+ // Stack size in bytes of the background flush task. File system writes, removes and renames need more than 2 kB
+ // on LittleFS and SD.
+#ifndef DISCORD_RECORDER_TASK_STACK
+#define DISCORD_RECORDER_TASK_STACK 4096
+#endif
+ // Maximum length of the recording's path.
+#ifndef DISCORD_RECORDER_PATH_LENGTH
+#define DISCORD_RECORDER_PATH_LENGTH 32
+#endif
+
+namespace Discord {
+    /*
+    Flight recorder for raw Gateway frames, to inspect field failures offline.
+    Frames are copied into a RAM staging buffer on the hot path and written to a file by a background task, in
+    batches. The recording is bounded: once the file reaches its maximum size it is renamed to <path>.old,
+    replacing the previous one, and a new file is started. When the staging buffer is full, new records are
+    dropped and counted rather than blocking the bot.
+
+    Recording format: a sequence of records, each a 10-byte header followed by the payload. All fields are
+    little-endian, offsets count from the start of the record.
+        offset 0  uint8   magic, 0xD5
+        offset 1  uint8   flags: bit 0 direction (0 received, 1 sent), bit 1 payload redacted,
+                          bit 7 payload truncated
+        offset 2  uint8   Gateway opcode, 0xFF if unknown (ETF frames)
+        offset 3  uint8   reserved, 0
+        offset 4  uint32  millis() when the frame was received or sent
+        offset 8  uint16  payload length in bytes (at most DISCORD_RECORDER_MAX_PAYLOAD)
+        offset 10 ...     payload, the frame exactly as it crossed the wire (JSON text or ETF)
+    Files always start and end on record boundaries, so <path>.old followed by <path> is a valid recording too.
+    FlightRecorder::read() walks a recording held in memory.
+    Sent Identify (op 2) and Resume (op 6) frames carry the bot token, so they are recorded with their header
+    only: the payload is left out, the length is 0 and the redacted flag is set. Nothing else is redacted.
+    */
+    class FlightRecorder {
+    public:
+        enum class Direction : uint8_t {
+            Received = 0,
+            Sent = 1
+        };
+
+        static const uint8_t MAGIC = 0xD5;
+        static const uint8_t REDACTED = 0x02;
+        static const uint8_t TRUNCATED = 0x80;
+        static const uint8_t UNKNOWN_OPCODE = 0xFF;
+        static const size_t HEADER_SIZE = 10;
+
+        struct Record {
+            uint32_t timestamp = 0;
+            Direction direction = Direction::Received;
+            uint8_t opcode = UNKNOWN_OPCODE;
+            bool truncated = false;
+            // The payload was left out because it holds the bot token.
+            bool redacted = false;
+            // Points into the recording passed to read()
+            const uint8_t* payload = nullptr;
+            uint16_t length = 0;
+        };
+
+        FlightRecorder();
+        ~FlightRecorder();
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        /// @brief Starts recording to a file and starts the background flush task.
+        /// @param fs The filesystem, e.g. LittleFS or SD, already mounted.
+        /// @param path The recording's path. The previous recording is kept at path + ".old".
+        /// @param maxFileSize Size in bytes after which the file is rotated.
+        /// @return False if the path is too long, the file cannot be opened or the task cannot be created.
+        bool begin(fs::FS& fs, const char* path, size_t maxFileSize = 64 * 1024);
+
+        /// @brief Writes out what is staged and stops recording.
+        void end();
+
+        /// @brief Stages a frame. Only copies into RAM, safe to call from the Gateway loop.
+        /// The payloads of sent Identify and Resume frames are not kept, see the format above.
+        /// @return False if the staging buffer is full and the record was dropped.
+        bool record(Direction direction, uint8_t opcode, const uint8_t* payload, size_t length, uint32_t timestamp);
+
+        /// @brief Writes the staged records to the file now, on the calling task.
+        /// @return The number of bytes written.
+        size_t flush();
+
+        bool recording() const { return _running; }
+        uint32_t recorded() const { return _recorded; }
+        uint32_t dropped() const { return _dropped; }
+
+        /// @brief Reads the next record of a recording.
+        /// @param data The recording, e.g. the contents of a recorder file.
+        /// @param length The size of the recording in bytes.
+        /// @param offset Where to read from, advanced past the record.
+        /// @param out The record, its payload points into data.
+        /// @return False at the end of the recording or if the record at offset is malformed or cut short.
+        static bool read(const uint8_t* data, size_t length, size_t& offset, Record& out);
+    private:
+        static void flushTask(void* parameter);
+
+        // Pops whole records from the staging buffer into out.
+        size_t take(uint8_t* out, size_t size);
+        void copyOut(size_t from, uint8_t* out, size_t length) const;
+        void append(const uint8_t* data, size_t length);
+        void rotate();
+
+        // Guards the staging buffer
+        std::mutex _mtx;
+        uint8_t _ring[DISCORD_RECORDER_BUFFER];
+        size_t _head = 0;
+        size_t _used = 0;
+
+        // Guards the file and _batch
+        std::mutex _writeMtx;
+        uint8_t _batch[HEADER_SIZE + DISCORD_RECORDER_MAX_PAYLOAD];
+        fs::FS* _fs = nullptr;
+        fs::File _file;
+        char _path[DISCORD_RECORDER_PATH_LENGTH + 1] = {};
+        char _oldPath[DISCORD_RECORDER_PATH_LENGTH + 5] = {};
+        size_t _maxFileSize = 0;
+        size_t _fileSize = 0;
+
+        std::atomic<TaskHandle_t> _task;
+        std::atomic<bool> _running;
+        std::atomic<uint32_t> _recorded;
+        std::atomic<uint32_t> _dropped;
+    };
+}
+
+#endif //_DISCORD_ESP32A_RECORDER_H_
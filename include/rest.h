@@ -0,0 +1,204 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <condition_variable>
+#include <mutex>
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+#include "metrics.h"
+
+#ifndef _DISCORD_ESP32A_REST_H_
+#define _DISCORD_ESP32A_REST_H_
+
+ // Number of channels/webhooks whose REST rate limit state is remembered at once.
+#ifndef DISCORD_RATE_LIMIT_BUCKETS
+#define DISCORD_RATE_LIMIT_BUCKETS 4
+#endif
+
+ // Minimum time in ms between Identify payloads of bots sharing a RestClient. Discord allows one per 5 seconds
+ // unless the bot's max_concurrency is higher.
+#ifndef DISCORD_IDENTIFY_INTERVAL
+#define DISCORD_IDENTIFY_INTERVAL 5000
+#endif
+
+ // Hostname the REST connection is opened to.
+#ifndef DISCORD_REST_HOST
+#define DISCORD_REST_HOST "discord.com"
+#endif
+
+ // Time budgets in ms the REST scheduler orders requests by. Interaction responses count from when the interaction
+ // was received, Discord drops them after 3 seconds.
+#ifndef DISCORD_INTERACTION_DEADLINE
+#define DISCORD_INTERACTION_DEADLINE 3000
+#endif
+#ifndef DISCORD_MESSAGE_DEADLINE
+#define DISCORD_MESSAGE_DEADLINE 10000
+#endif
+#ifndef DISCORD_BULK_DEADLINE
+#define DISCORD_BULK_DEADLINE 30000
+#endif
+ // Number of requests that can wait for the connection at once, further ones wait for a free place first.
+#ifndef DISCORD_REST_SCHEDULER_SLOTS
+#define DISCORD_REST_SCHEDULER_SLOTS 8
+#endif
+
+namespace Discord {
+    // Priority classes of REST work, in the order they go first when their deadlines are equal.
+    enum class RestPriority : uint8_t {
+        // Interaction callbacks, due DISCORD_INTERACTION_DEADLINE after the interaction arrived
+        Interaction,
+        // Channel messages and webhooks
+        Message,
+        // Command registration, the Gateway keep-alive and anything else
+        Bulk
+    };
+
+    /*
+    Hands the REST connection to one request at a time, earliest deadline first rather than in arrival order, so
+    that an interaction response does not wait behind a slow command registration. Requests with equal deadlines
+    go by priority class, then arrival.
+    Also usable as a plain lock (lock()/unlock()), which queues as bulk work.
+    */
+    class RestScheduler {
+    public:
+        RestScheduler() {}
+        RestScheduler(const RestScheduler&) = delete;
+        RestScheduler& operator=(const RestScheduler&) = delete;
+
+        /// @brief Waits for the connection. Call release() when done with it.
+        /// @param deadline millis() by which the request should be sent.
+        /// @param priority Breaks ties between equal deadlines.
+        /// @return True if the deadline had already passed by the time the connection was free.
+        bool acquire(unsigned long deadline, RestPriority priority);
+        void release();
+
+        void lock() { acquire(deadline(RestPriority::Bulk, millis()), RestPriority::Bulk); }
+        void unlock() { release(); }
+
+        /// @brief The deadline of a request of the given class, counted from since.
+        static unsigned long deadline(RestPriority priority, unsigned long since);
+
+        /// @brief Requests currently waiting for the connection.
+        size_t waiting();
+    private:
+        struct Waiter {
+            unsigned long deadline = 0;
+            uint32_t ticket = 0;
+            RestPriority priority = RestPriority::Bulk;
+            bool used = false;
+        };
+
+        // True if no other waiter goes before the one in this slot.
+        bool first(size_t slot) const;
+        size_t freeSlot() const;
+
+        std::mutex _mtx;
+        std::condition_variable _changed;
+        bool _busy = false;
+        uint32_t _nextTicket = 0;
+        Waiter _waiters[DISCORD_REST_SCHEDULER_SLOTS];
+    };
+
+    /*
+    Holds the REST connection for the lifetime of a scope, see RestScheduler::acquire().
+    */
+    class RestTurn {
+    public:
+        RestTurn(RestScheduler& scheduler, unsigned long deadline, RestPriority priority) : _scheduler { scheduler } {
+            _missed = _scheduler.acquire(deadline, priority);
+        }
+        ~RestTurn() { _scheduler.release(); }
+        RestTurn(const RestTurn&) = delete;
+        RestTurn& operator=(const RestTurn&) = delete;
+
+        bool missedDeadline() const { return _missed; }
+    private:
+        RestScheduler& _scheduler;
+        bool _missed = false;
+    };
+
+    /*
+    The HTTP connection and rate limit state behind a bot's REST calls.
+    Every bot has its own by default. Shards of one application running in the same process can share one
+    instead, by constructing them with it: they then use a single HTTP connection and scheduler, see each
+    other's rate limits, and take turns to identify.
+    The TLS connection is kept alive between requests and across Gateway reconnects, and is only reopened when
+    Discord closes it. The heartbeat's periodic REST request keeps it from idling out.
+    */
+    class RestClient {
+    public:
+        RestClient() {}
+        RestClient(const RestClient&) = delete;
+        RestClient& operator=(const RestClient&) = delete;
+
+        /// @brief Opens the HTTP client. Does nothing if it is already open.
+        void begin();
+        /// @brief Closes the connection. The next request after begin() pays for a full handshake.
+        void end();
+
+        /// @brief Makes sure the TLS connection is open, call while holding a scheduler() turn.
+        /// A handshake is timed into metrics->tlsHandshake() and counted as TlsHandshakes, a warm connection is
+        /// counted as RestConnectionsReused.
+        /// @param metrics Where to record the outcome, may be nullptr.
+        /// @return False if the connection could not be opened.
+        bool connect(Metrics* metrics);
+
+        /// @brief Number of TLS handshakes performed since construction.
+        uint32_t handshakes() const { return _handshakes; }
+
+        HTTPClient& http() { return _https; }
+        // Decides whose turn it is to use http()
+        RestScheduler& scheduler() { return _scheduler; }
+
+        /// @brief True if the channel or webhook is out of requests until its bucket resets.
+        bool rateLimited(uint64_t key);
+
+        /// @brief Records the rate limit headers of a response for a channel or webhook.
+        void updateRateLimit(uint64_t key, int httpResponseCode);
+
+        /// @brief Takes the next Identify slot if DISCORD_IDENTIFY_INTERVAL has passed since the last one.
+        /// @return True if the caller may identify now.
+        bool claimIdentify(unsigned long now);
+    private:
+        struct RateLimitBucket {
+            // Channel or webhook id
+            uint64_t key = 0;
+            uint16_t remaining = 1;
+            // millis() at which the bucket refills
+            unsigned long resetAt = 0;
+        };
+
+        WiFiClientSecure _tls;
+        HTTPClient _https;
+        RestScheduler _scheduler;
+        bool _begun = false;
+        uint32_t _handshakes = 0;
+
+        std::mutex _rateLimitMtx;
+        RateLimitBucket _rateLimits[DISCORD_RATE_LIMIT_BUCKETS];
+
+        std::mutex _identifyMtx;
+        unsigned long _lastIdentify = 0;
+        bool _identified = false;
+    };
+}
+
+#endif //_DISCORD_ESP32A_REST_H_
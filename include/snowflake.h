@@ -0,0 +1,134 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_SNOWFLAKE_H_
+#define _DISCORD_ESP32A_SNOWFLAKE_H_
+
+ // Milliseconds since the Unix epoch at the start of 2015, the zero point of snowflake timestamps.
+#define DISCORD_EPOCH 1420070400000ULL
+
+ // Maximum number of decimal digits in a snowflake, excluding the terminator.
+#define DISCORD_SNOWFLAKE_DIGITS 20
+
+ // Size of the stack buffer REST URLs are built in. Interaction callback URLs carry the interaction token,
+ // which makes them the longest ones the library builds.
+#ifndef DISCORD_URL_LENGTH
+#define DISCORD_URL_LENGTH 384
+#endif
+
+namespace Discord {
+    /*
+    A Discord id. Converts implicitly to and from uint64_t, and parses from decimal strings without allocating.
+    */
+    struct Snowflake {
+        uint64_t value = 0;
+
+        Snowflake() {}
+        Snowflake(uint64_t id) : value { id } {}
+        // Parses a decimal string, invalid input gives 0.
+        Snowflake(const char* str) { parse(str, str ? strlen(str) : 0, *this); }
+        Snowflake(const String& str) { parse(str.c_str(), str.length(), *this); }
+
+        operator uint64_t() const { return value; }
+
+        /// @brief Unix timestamp in ms of when the id was created.
+        uint64_t timestamp() const { return (value >> 22) + DISCORD_EPOCH; }
+        uint8_t workerId() const { return (value >> 17) & 0x1F; }
+        uint8_t processId() const { return (value >> 12) & 0x1F; }
+        uint16_t increment() const { return value & 0xFFF; }
+
+        /// @brief Parses a decimal snowflake.
+        /// @param str The digits, does not need to be null-terminated.
+        /// @param length The number of characters to read.
+        /// @param out Receives the id, or 0 on failure.
+        /// @return False if the input is empty, has a non-digit or overflows 64 bits.
+        static bool parse(const char* str, size_t length, Snowflake& out) {
+            out.value = 0;
+            if (!str || length == 0 || length > DISCORD_SNOWFLAKE_DIGITS) return false;
+            uint64_t value = 0;
+            for (size_t i = 0; i < length; ++i) {
+                uint8_t digit = static_cast<uint8_t>(str[i] - '0');
+                if (digit > 9) return false;
+                if (value > (UINT64_MAX - digit) / 10) return false;
+                value = value * 10 + digit;
+            }
+            out.value = value;
+            return true;
+        }
+
+        /// @brief Writes the id in decimal.
+        /// @param buffer Room for at least DISCORD_SNOWFLAKE_DIGITS + 1 characters.
+        /// @return The number of digits written, excluding the terminator.
+        size_t format(char* buffer) const {
+            char digits[DISCORD_SNOWFLAKE_DIGITS];
+            size_t length = 0;
+            uint64_t remaining = value;
+            do {
+                digits[length++] = '0' + remaining % 10;
+                remaining /= 10;
+            } while (remaining > 0);
+            for (size_t i = 0; i < length; ++i) {
+                buffer[i] = digits[length - 1 - i];
+            }
+            buffer[length] = '\0';
+            return length;
+        }
+    };
+
+    /*
+    Fixed-size, stack allocated string builder for REST URLs. Appending past the end sets overflowed() instead of
+    writing out of bounds.
+    */
+    template <size_t N = DISCORD_URL_LENGTH>
+    class UrlBuilder {
+    public:
+        UrlBuilder() { _buffer[0] = '\0'; }
+        UrlBuilder(const char* base) : UrlBuilder() { *this += base; }
+
+        UrlBuilder& append(const char* str, size_t length) {
+            if (_length + length >= N) {
+                _overflowed = true;
+                return *this;
+            }
+            memcpy(_buffer + _length, str, length);
+            _length += length;
+            _buffer[_length] = '\0';
+            return *this;
+        }
+
+        UrlBuilder& operator+=(const char* str) { return append(str, strlen(str)); }
+        UrlBuilder& operator+=(const String& str) { return append(str.c_str(), str.length()); }
+        UrlBuilder& operator+=(Snowflake id) {
+            char digits[DISCORD_SNOWFLAKE_DIGITS + 1];
+            return append(digits, id.format(digits));
+        }
+        UrlBuilder& operator+=(uint64_t id) { return *this += Snowflake(id); }
+
+        const char* c_str() const { return _buffer; }
+        size_t length() const { return _length; }
+        bool overflowed() const { return _overflowed; }
+    private:
+        char _buffer[N];
+        size_t _length = 0;
+        bool _overflowed = false;
+    };
+}
+
+#endif //_DISCORD_ESP32A_SNOWFLAKE_H_
@@ -0,0 +1,102 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+
+#ifndef _DISCORD_ESP32A_TIMERS_H_
+#define _DISCORD_ESP32A_TIMERS_H_
+
+namespace Discord {
+    /*
+    Hierarchical timer wheel with 1 ms ticks: four levels of 64 slots, covering 1 ms, 64 ms, 4 s and 4.6 h per
+    slot. Scheduling and cancelling are O(1). Advancing skips empty stretches a level at a time, and timers
+    further out are cascaded down as their level comes round.
+    Time is kept as differences of millis() values, so the wheel runs through the 49 day wraparound. Delays
+    must stay below 2^31 ms.
+    Timers are intrusive: the caller owns them and the wheel only links them into its slots. A timer must not be
+    moved or destroyed while it is scheduled. Not thread safe, use it from one task.
+    */
+    class TimerWheel {
+    public:
+        class Timer {
+        public:
+            Timer() {}
+            Timer(const Timer&) = delete;
+            Timer& operator=(const Timer&) = delete;
+
+            bool armed() const { return _armed; }
+        private:
+            friend class TimerWheel;
+
+            Timer* _next = nullptr;
+            Timer* _prev = nullptr;
+            uint32_t _deadline = 0;
+            uint8_t _level = 0;
+            uint8_t _slot = 0;
+            bool _armed = false;
+            bool _fired = false;
+        };
+
+        // Returned by nextDeadline() when no timer is scheduled.
+        static const unsigned long NONE = static_cast<unsigned long>(-1);
+
+        TimerWheel();
+
+        /// @brief Schedules a timer, replacing its previous deadline if it was already scheduled.
+        /// It fires on the first advance() at or after now + delay, at least 1 ms after now.
+        /// @param timer The timer, owned by the caller.
+        /// @param now The current time from millis().
+        /// @param delay Time in ms from now.
+        void schedule(Timer& timer, unsigned long now, unsigned long delay);
+
+        /// @brief Unschedules a timer and clears its fired flag.
+        void cancel(Timer& timer);
+
+        /// @brief Moves the wheel forward to now and fires every timer whose deadline has passed.
+        void advance(unsigned long now);
+
+        /// @brief True once after the timer fires, until it is checked, scheduled again or cancelled.
+        bool fired(Timer& timer);
+
+        /// @brief Time in ms from the last advance() to the earliest scheduled deadline, or NONE.
+        unsigned long nextDeadline() const;
+
+        size_t size() const { return _count; }
+    private:
+        static const uint8_t LEVELS = 4;
+        static const uint8_t SLOT_BITS = 6;
+        static const uint8_t SLOTS = 1 << SLOT_BITS;
+
+        // Index of the slot that tick falls in on a level.
+        static uint8_t slotOf(uint32_t tick, uint8_t level) { return (tick >> (level * SLOT_BITS)) & (SLOTS - 1); }
+
+        void insert(Timer& timer);
+        void unlink(Timer& timer);
+        void cascade(uint8_t level, uint8_t slot);
+        void expire(uint8_t slot);
+
+        Timer* _slots[LEVELS][SLOTS];
+        // Bit i is set while slot i of the level holds timers
+        uint64_t _occupied[LEVELS];
+        // The last tick advance() processed
+        uint32_t _current = 0;
+        size_t _count = 0;
+    };
+}
+
+#endif //_DISCORD_ESP32A_TIMERS_H_
@@ -0,0 +1,57 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <admission.h>
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+namespace Discord {
+    AdmissionController::Decision AdmissionController::decide(const Pressure& pressure) const {
+        if (!enabled) return Decision::Admit;
+        if (pressure.freeHeap < thresholds.dropBlock || pressure.largestBlock < thresholds.dropBlock) {
+            return Decision::Drop;
+        }
+        if (pressure.freeHeap < thresholds.minFreeHeap ||
+            pressure.restQueue >= thresholds.maxRestQueue ||
+            pressure.pendingInteractions >= thresholds.maxPendingInteractions) {
+            return Decision::Busy;
+        }
+        return Decision::Admit;
+    }
+
+    void AdmissionController::sampleMemory(Pressure& pressure) {
+#ifdef ESP32
+        pressure.freeHeap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        pressure.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        pressure.freeHeap = UINT32_MAX;
+        pressure.largestBlock = UINT32_MAX;
+#endif
+    }
+
+    const char* AdmissionController::busyResponse(uint8_t interactionType) {
+        // APPLICATION_COMMAND_AUTOCOMPLETE only accepts APPLICATION_COMMAND_AUTOCOMPLETE_RESULT.
+        if (interactionType == 4) {
+            return "{\"type\":8,\"data\":{\"choices\":[]}}";
+        }
+        // CHANNEL_MESSAGE_WITH_SOURCE, EPHEMERAL
+        return "{\"type\":4,\"data\":{\"content\":\"" DISCORD_BUSY_MESSAGE "\",\"flags\":64}}";
+    }
+}
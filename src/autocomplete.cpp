@@ -0,0 +1,147 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <autocomplete.h>
+
+namespace Discord {
+    namespace {
+        const char responseHead[] = "{\"type\":8,\"data\":{\"choices\":[";
+    }
+
+    void AutocompleteResponse::clear() {
+        memcpy(_buffer, responseHead, sizeof(responseHead));
+        _length = sizeof(responseHead) - 1;
+        _count = 0;
+    }
+
+    bool AutocompleteResponse::add(const char* name, const char* value) {
+        size_t mark = _length;
+        if (!beginChoice(name) || !append("\"", 1) || !appendEscaped(value) || !append("\"}", 2)) {
+            _length = mark;
+            return false;
+        }
+        ++_count;
+        return true;
+    }
+
+    bool AutocompleteResponse::add(const char* name, long value) {
+        size_t mark = _length;
+        char digits[24];
+        int n = snprintf(digits, sizeof(digits), "%ld", value);
+        if (!beginChoice(name) || !append(digits, n) || !append("}", 1)) {
+            _length = mark;
+            return false;
+        }
+        ++_count;
+        return true;
+    }
+
+    size_t AutocompleteResponse::add(const AutocompleteChoice* choices, size_t count) {
+        size_t added = 0;
+        while (added < count && add(choices[added])) {
+            ++added;
+        }
+        return added;
+    }
+
+    const char* AutocompleteResponse::json() {
+        // Room for the closing brackets is always kept free by append().
+        memcpy(_buffer + _length, "]}}", 4);
+        return _buffer;
+    }
+
+    bool AutocompleteResponse::beginChoice(const char* name) {
+        if (_count >= DISCORD_AUTOCOMPLETE_MAX_CHOICES) return false;
+        if (_count > 0 && !append(",", 1)) return false;
+        return append("{\"name\":\"", 9) && appendEscaped(name) && append("\",\"value\":", 10);
+    }
+
+    bool AutocompleteResponse::append(const char* str, size_t length) {
+        // Keep 4 bytes for "]}}" and the terminator.
+        if (_length + length + 4 > sizeof(_buffer)) return false;
+        memcpy(_buffer + _length, str, length);
+        _length += length;
+        return true;
+    }
+
+    bool AutocompleteResponse::appendEscaped(const char* str) {
+        if (!str) return true;
+        for (; *str; ++str) {
+            char c = *str;
+            bool ok;
+            if (c == '"' || c == '\\') {
+                char escaped[2] = { '\\', c };
+                ok = append(escaped, 2);
+            }
+            else if (static_cast<uint8_t>(c) < 0x20) {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                ok = append(escaped, 6);
+            }
+            else {
+                ok = append(&c, 1);
+            }
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    AutocompleteIndex::AutocompleteIndex(AutocompleteChoice* choices, size_t count) :
+        _choices { choices }, _count { count } {
+        // Insertion sort, the sets are small and this runs once at setup.
+        for (size_t i = 1; i < _count; ++i) {
+            AutocompleteChoice choice = _choices[i];
+            size_t j = i;
+            while (j > 0 && strcasecmp(_choices[j - 1].name, choice.name) > 0) {
+                _choices[j] = _choices[j - 1];
+                --j;
+            }
+            _choices[j] = choice;
+        }
+    }
+
+    size_t AutocompleteIndex::match(const char* prefix, const AutocompleteChoice*& first) const {
+        if (!prefix) prefix = "";
+        size_t prefixLength = strlen(prefix);
+        // Matches form one run: find the first name not ordered before the prefix, then the first one after it.
+        size_t low = 0;
+        size_t high = _count;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (strncasecmp(_choices[mid].name, prefix, prefixLength) < 0) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        size_t begin = low;
+        high = _count;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (strncasecmp(_choices[mid].name, prefix, prefixLength) <= 0) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        first = _choices + begin;
+        return low - begin;
+    }
+}
@@ -0,0 +1,326 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cache.h>
+
+namespace Discord {
+    Cache::Cache() {}
+
+    template <typename T, size_t N>
+    T* Cache::find(T (&records)[N], size_t count, uint64_t id) {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (records[mid].id < id) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        return low < count && records[low].id == id ? &records[low] : nullptr;
+    }
+
+    template <typename T, size_t N>
+    T* Cache::insert(T (&records)[N], size_t& count, uint64_t id) {
+        T* existing = find(records, count, id);
+        if (existing) return existing;
+
+        if (count == N) {
+            size_t victim = leastRecentlyUsed(records, count);
+            release(records[victim].name);
+            memmove(&records[victim], &records[victim + 1], (count - victim - 1) * sizeof(T));
+            --count;
+        }
+
+        size_t position = 0;
+        while (position < count && records[position].id < id) {
+            ++position;
+        }
+        memmove(&records[position + 1], &records[position], (count - position) * sizeof(T));
+        records[position] = T();
+        records[position].id = id;
+        ++count;
+        return &records[position];
+    }
+
+    template <typename T, size_t N>
+    T* Cache::upsert(T (&records)[N], size_t& count, uint64_t id, const char* name) {
+        // Intern first: making room in the pool may evict records, which would move any record pointer we held.
+        uint16_t handle = intern(name);
+        T* record = insert(records, count, id);
+        release(record->name);
+        record->name = handle;
+        record->lastUsed = ++_clock;
+        return record;
+    }
+
+    template <typename T, size_t N>
+    void Cache::remove(T (&records)[N], size_t& count, uint64_t id) {
+        T* record = find(records, count, id);
+        if (!record) return;
+        release(record->name);
+        size_t index = record - records;
+        memmove(&records[index], &records[index + 1], (count - index - 1) * sizeof(T));
+        --count;
+    }
+
+    template <typename T, size_t N>
+    size_t Cache::leastRecentlyUsed(T (&records)[N], size_t count) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < count; ++i) {
+            // Compare by age so the LRU order survives the clock wrapping around.
+            if (_clock - records[i].lastUsed > _clock - records[oldest].lastUsed) {
+                oldest = i;
+            }
+        }
+        return oldest;
+    }
+
+    const Cache::Guild* Cache::guild(uint64_t id) {
+        Guild* record = find(_guilds, _guildCount, id);
+        if (record) record->lastUsed = ++_clock;
+        return record;
+    }
+
+    const Cache::Channel* Cache::channel(uint64_t id) {
+        Channel* record = find(_channels, _channelCount, id);
+        if (record) record->lastUsed = ++_clock;
+        return record;
+    }
+
+    const Cache::Role* Cache::role(uint64_t id) {
+        Role* record = find(_roles, _roleCount, id);
+        if (record) record->lastUsed = ++_clock;
+        return record;
+    }
+
+    const char* Cache::str(uint16_t handle) const {
+        if (handle == NO_STRING || handle >= _poolUsed) return "";
+        return reinterpret_cast<const char*>(&_pool[handle + 2]);
+    }
+
+    uint64_t Cache::permissions(uint64_t guildId, const uint64_t* roleIds, size_t roleCount) {
+        // The @everyone role shares its id with the guild.
+        const Role* everyone = role(guildId);
+        uint64_t result = everyone ? everyone->permissions : 0;
+        for (size_t i = 0; i < roleCount; ++i) {
+            const Role* r = role(roleIds[i]);
+            if (r && r->guildId == guildId) {
+                result |= r->permissions;
+            }
+        }
+        return result;
+    }
+
+    bool Cache::tracks(const char* type) {
+        return strncmp(type, "GUILD_", 6) == 0 || strncmp(type, "CHANNEL_", 8) == 0;
+    }
+
+    bool Cache::update(const char* type, JsonObjectConst data) {
+        if (!type || data.isNull()) return false;
+
+        if (strcmp(type, "GUILD_CREATE") == 0 || strcmp(type, "GUILD_UPDATE") == 0) {
+            updateGuild(data);
+            return true;
+        }
+        if (strcmp(type, "GUILD_DELETE") == 0) {
+            // Unavailable guilds are an outage, not a removal, so keep what we know.
+            if (!data["unavailable"].as<bool>()) {
+                removeGuild(Snowflake(data["id"].as<const char*>()));
+            }
+            return true;
+        }
+        if (strcmp(type, "CHANNEL_CREATE") == 0 || strcmp(type, "CHANNEL_UPDATE") == 0) {
+            Snowflake guildId = data["guild_id"].as<const char*>();
+            // DM channels have no guild and no name worth caching.
+            if (guildId != 0) {
+                updateChannel(guildId, data);
+            }
+            return true;
+        }
+        if (strcmp(type, "CHANNEL_DELETE") == 0) {
+            remove(_channels, _channelCount, Snowflake(data["id"].as<const char*>()));
+            return true;
+        }
+        if (strcmp(type, "GUILD_ROLE_CREATE") == 0 || strcmp(type, "GUILD_ROLE_UPDATE") == 0) {
+            updateRole(Snowflake(data["guild_id"].as<const char*>()), data["role"]);
+            return true;
+        }
+        if (strcmp(type, "GUILD_ROLE_DELETE") == 0) {
+            remove(_roles, _roleCount, Snowflake(data["role_id"].as<const char*>()));
+            return true;
+        }
+        return false;
+    }
+
+    void Cache::updateGuild(JsonObjectConst data) {
+        Snowflake id = data["id"].as<const char*>();
+        if (id == 0) return;
+        upsert(_guilds, _guildCount, id, data["name"]);
+
+        // GUILD_CREATE channels carry no guild_id, they all belong to this guild.
+        for (JsonObjectConst channel : data["channels"].as<JsonArrayConst>()) {
+            updateChannel(id, channel);
+        }
+        for (JsonObjectConst role : data["roles"].as<JsonArrayConst>()) {
+            updateRole(id, role);
+        }
+    }
+
+    void Cache::updateChannel(uint64_t guildId, JsonObjectConst data) {
+        Snowflake id = data["id"].as<const char*>();
+        if (id == 0) return;
+        Channel* record = upsert(_channels, _channelCount, id, data["name"]);
+        record->guildId = guildId;
+        record->type = data["type"];
+    }
+
+    void Cache::updateRole(uint64_t guildId, JsonObjectConst data) {
+        Snowflake id = data["id"].as<const char*>();
+        if (id == 0) return;
+        Role* record = upsert(_roles, _roleCount, id, data["name"]);
+        record->guildId = guildId;
+        // Permissions are a bit set serialized as a decimal string, same as a snowflake.
+        record->permissions = Snowflake(data["permissions"].as<const char*>());
+        record->color = data["color"];
+        record->position = data["position"];
+    }
+
+    void Cache::removeGuild(uint64_t id) {
+        remove(_guilds, _guildCount, id);
+        size_t kept = 0;
+        for (size_t i = 0; i < _channelCount; ++i) {
+            if (_channels[i].guildId == id) {
+                release(_channels[i].name);
+            }
+            else {
+                _channels[kept++] = _channels[i];
+            }
+        }
+        _channelCount = kept;
+        kept = 0;
+        for (size_t i = 0; i < _roleCount; ++i) {
+            if (_roles[i].guildId == id) {
+                release(_roles[i].name);
+            }
+            else {
+                _roles[kept++] = _roles[i];
+            }
+        }
+        _roleCount = kept;
+    }
+
+    void Cache::clear() {
+        _guildCount = 0;
+        _channelCount = 0;
+        _roleCount = 0;
+        _poolUsed = 0;
+    }
+
+    uint16_t Cache::intern(const char* name) {
+        if (!name) name = "";
+        size_t length = strlen(name);
+        if (length > DISCORD_CACHE_NAME_LENGTH) {
+            length = DISCORD_CACHE_NAME_LENGTH;
+            // Do not cut a UTF-8 sequence in half.
+            while (length > 0 && (static_cast<uint8_t>(name[length]) & 0xC0) == 0x80) {
+                --length;
+            }
+        }
+
+        // Share an existing copy if there is one.
+        for (size_t offset = 0; offset < _poolUsed; offset += 3 + _pool[offset + 1]) {
+            uint8_t refs = _pool[offset];
+            if (refs > 0 && refs < 255 && _pool[offset + 1] == length &&
+                memcmp(&_pool[offset + 2], name, length) == 0) {
+                ++_pool[offset];
+                return offset;
+            }
+        }
+
+        size_t needed = length + 3;
+        if (needed > DISCORD_CACHE_STRING_POOL) return NO_STRING;
+        while (_poolUsed + needed > DISCORD_CACHE_STRING_POOL) {
+            compact();
+            if (_poolUsed + needed <= DISCORD_CACHE_STRING_POOL) break;
+            if (!evictOne()) return NO_STRING;
+        }
+
+        uint16_t handle = _poolUsed;
+        _pool[handle] = 1;
+        _pool[handle + 1] = length;
+        memcpy(&_pool[handle + 2], name, length);
+        _pool[handle + 2 + length] = '\0';
+        _poolUsed += needed;
+        return handle;
+    }
+
+    void Cache::release(uint16_t handle) {
+        if (handle == NO_STRING || handle >= _poolUsed) return;
+        if (_pool[handle] > 0) {
+            --_pool[handle];
+        }
+    }
+
+    void Cache::compact() {
+        size_t to = 0;
+        size_t from = 0;
+        while (from < _poolUsed) {
+            size_t size = 3 + _pool[from + 1];
+            if (_pool[from] > 0) {
+                if (to != from) {
+                    memmove(&_pool[to], &_pool[from], size);
+                    remapHandle(from, to);
+                }
+                to += size;
+            }
+            from += size;
+        }
+        _poolUsed = to;
+    }
+
+    void Cache::remapHandle(uint16_t from, uint16_t to) {
+        for (size_t i = 0; i < _guildCount; ++i) {
+            if (_guilds[i].name == from) _guilds[i].name = to;
+        }
+        for (size_t i = 0; i < _channelCount; ++i) {
+            if (_channels[i].name == from) _channels[i].name = to;
+        }
+        for (size_t i = 0; i < _roleCount; ++i) {
+            if (_roles[i].name == from) _roles[i].name = to;
+        }
+    }
+
+    bool Cache::evictOne() {
+        // Channels and roles are the bulk of the cache, evict whichever was used least recently.
+        if (_channelCount == 0 && _roleCount == 0) return false;
+        size_t channel = leastRecentlyUsed(_channels, _channelCount);
+        size_t role = leastRecentlyUsed(_roles, _roleCount);
+        bool evictChannel = _roleCount == 0 ||
+            (_channelCount > 0 && _clock - _channels[channel].lastUsed >= _clock - _roles[role].lastUsed);
+        if (evictChannel) {
+            remove(_channels, _channelCount, _channels[channel].id);
+        }
+        else {
+            remove(_roles, _roleCount, _roles[role].id);
+        }
+        return true;
+    }
+}
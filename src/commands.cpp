@@ -0,0 +1,97 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <commands.h>
+
+namespace {
+    bool isBlank(char c) {
+        return isspace(static_cast<unsigned char>(c));
+    }
+}
+
+namespace Discord {
+    bool PrefixCommands::Token::equals(const char* other) const {
+        return other && strncmp(str, other, length) == 0 && other[length] == '\0';
+    }
+
+    size_t PrefixCommands::Token::copy(char* buffer, size_t size) const {
+        if (size == 0) return 0;
+        size_t copied = length < size - 1 ? length : size - 1;
+        memcpy(buffer, str, copied);
+        buffer[copied] = '\0';
+        return copied;
+    }
+
+    PrefixCommands::PrefixCommands(const char* prefix) :
+        _prefix { prefix ? prefix : "" }, _prefixLength { strlen(_prefix) } {}
+
+    bool PrefixCommands::add(const char* name, const Handler& handler) {
+        // An empty name would make the bare prefix a command.
+        if (!name || name[0] == '\0') return false;
+        int index = _names.add(name);
+        if (index < 0) return false;
+        _handlers[index] = handler;
+        return true;
+    }
+
+    bool PrefixCommands::dispatch(const char* content, const JsonObject& message) const {
+        if (!content || _names.size() == 0 || strncmp(content, _prefix, _prefixLength) != 0) return false;
+        const char* name = content + _prefixLength;
+        size_t length = 0;
+        while (name[length] != '\0' && !isBlank(name[length])) {
+            ++length;
+        }
+        if (length == 0) return false;
+
+        int index = _names.find(name, length);
+        if (index < 0 || !_handlers[index]) return false;
+        Arguments args;
+        tokenize(name + length, args);
+        _handlers[index](args, message);
+        return true;
+    }
+
+    void PrefixCommands::tokenize(const char* text, Arguments& out) {
+        out._count = 0;
+        out._truncated = false;
+        const char* p = text;
+        while (*p != '\0' && isBlank(*p)) ++p;
+        out._rest.str = p;
+        out._rest.length = strlen(p);
+
+        while (*p != '\0') {
+            if (out._count == DISCORD_PREFIX_COMMAND_ARGS) {
+                out._truncated = true;
+                return;
+            }
+            Token& token = out._values[out._count++];
+            if (*p == '"') {
+                token.str = ++p;
+                while (*p != '\0' && *p != '"') ++p;
+                token.length = p - token.str;
+                if (*p == '"') ++p;
+            }
+            else {
+                token.str = p;
+                while (*p != '\0' && !isBlank(*p)) ++p;
+                token.length = p - token.str;
+            }
+            while (*p != '\0' && isBlank(*p)) ++p;
+        }
+    }
+}
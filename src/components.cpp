@@ -0,0 +1,50 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <components.h>
+
+namespace Discord {
+    bool ComponentRouter::add(const char* prefix, const Handler& handler) {
+        int index = _prefixes.add(prefix);
+        if (index < 0) return false;
+        _handlers[index] = handler;
+        return true;
+    }
+
+    bool ComponentRouter::dispatch(const char* customId, const JsonObject& interaction) const {
+        if (!customId) return false;
+        const char* separator = strchr(customId, DISCORD_COMPONENT_SEPARATOR);
+        size_t length = separator ? separator - customId : strlen(customId);
+        int index = _prefixes.find(customId, length);
+        if (index < 0 || !_handlers[index]) return false;
+        _handlers[index](separator ? separator + 1 : "", interaction);
+        return true;
+    }
+
+    const char* ComponentRouter::modalValue(const JsonObject& interaction, const char* customId) {
+        // Modal submissions carry their text inputs as action rows of components.
+        for (JsonObject row : interaction["data"]["components"].as<JsonArray>()) {
+            for (JsonObject input : row["components"].as<JsonArray>()) {
+                if (input["custom_id"] == customId) {
+                    return input["value"];
+                }
+            }
+        }
+        return nullptr;
+    }
+}
@@ -22,12 +22,58 @@
  //TODO: Avoid hardcoding Serial entirely
 namespace Discord {
 
-    Bot::Bot(bool enableRateLimit) : _rateLimit { enableRateLimit } {}
+    Bot::Bot(bool enableRateLimit) :
+        _rest { &_ownRest }, _https { _ownRest.http() }, _restScheduler { _ownRest.scheduler() },
+        _rateLimit { enableRateLimit } {}
 
-    void Bot::login(const char* botToken, unsigned int intents) {
+    Bot::Bot(RestClient& rest, bool enableRateLimit) :
+        _rest { &rest }, _https { rest.http() }, _restScheduler { rest.scheduler() }, _rateLimit { enableRateLimit } {}
+
+    void Bot::setShard(uint16_t shardId, uint16_t shardCount) {
+        _shardId = shardId;
+        _shardCount = shardCount;
+        _identifyPayload.clear();
+    }
+
+    void Bot::setToken(const char* botToken) {
         _botToken = botToken;
+        _identifyPayload.clear();
+        _resumePayload.clear();
+        _rest->begin();
+    }
+
+    void Bot::login(const char* botToken, Intents intents) {
+        setToken(botToken);
+        _intents = intents;
+        _identifyPayload.clear();
+
+        _socket.onEvent([=](WStype_t type, uint8_t* payload, size_t length) {
+            this->onWebSocketEvents(type, payload, length);
+            });
+        // Reconnects are paced by the bot's own backoff, keep the socket from retrying on its own within an attempt.
+        _socket.setReconnectInterval(DISCORD_HANDSHAKE_TIMEOUT);
+
+        _now = millis();
+        _reconnectStats.consecutiveFailures = 0;
+        connect();
+    }
+
+    void Bot::connect() {
+        stopHeartbeat();
+        _pendingReconnect = PendingReconnect::None;
+        _identifyQueued = false;
+        _timers.cancel(_identifyTimer);
+        ++_reconnectStats.attempts;
+
+        // Resume on the URL handed out in READY if we still hold a session.
+        if (!_sessionId.isEmpty() && !_resumeURL.isEmpty()) {
+            Serial.print(DISCORD_LOG_PREFIX "Attempting to resume via WebSocket on ");
+            Serial.println(_resumeURL);
+            _socket.beginSSL(_resumeURL, 443, DISCORD_GATEWAY_SUFFIX);
+            setState(ConnectionState::Connecting);
+            return;
+        }
 
-        _https.begin(DISCORD_HOST, nullptr);
         //Establish a connection with the Gateway after fetching and caching a WSS URL using the Get Gateway endpoint.
         if (_gatewayURL.isEmpty()) {
             StaticJsonDocument<64> doc;
@@ -42,29 +88,32 @@ namespace Discord {
 #else
                 Serial.println(DISCORD_LOG_PREFIX "Failed to set Gateway URL.");
 #endif
+                ++_reconnectStats.failures;
+                ++_reconnectStats.consecutiveFailures;
+                scheduleReconnect(false, backoffDelay());
                 return;
             }
         }
 
-        _socket.onEvent([=](WStype_t type, uint8_t* payload, size_t length) {
-            this->onWebSocketEvents(type, payload, length);
-            });
         Serial.print(DISCORD_LOG_PREFIX "Attempting connection via WebSocket to ");
         Serial.println(_gatewayURL);
         _socket.beginSSL(_gatewayURL, 443, DISCORD_GATEWAY_SUFFIX);
-
-        _intents = intents;
-        _heartbeatInterval = 0;
-        _lastHeartbeatAck = 0;
-        _lastHeartbeatSend = 0;
+        setState(ConnectionState::Connecting);
     }
 
-    void Bot::update() {
-        update(millis());
+    unsigned long Bot::update() {
+        return update(millis());
     }
 
-    void Bot::update(unsigned long now) {
+    unsigned long Bot::update(unsigned long now) {
         _now = now;
+        _timers.advance(now);
+
+        if (_timers.fired(_interactionTimer)) {
+            // Discord would refuse anything sent with the token from now on.
+            _interactionId = 0;
+            _interactionToken.clear();
+        }
 
         // Process event queue
         if (_outerCallback) {
@@ -72,47 +121,288 @@ namespace Discord {
                 --_eventQueueIndex;
                 _outerCallback(_eventQueue[_eventQueueIndex].type, _eventQueue[_eventQueueIndex]);
             }
+            _metrics.setGauge(Metrics::Gauge::EventQueueDepth, 0);
+        }
+
+        // Batched messages are plain REST, so they go out whatever state the Gateway is in.
+        for (size_t i = 0; i < DISCORD_MESSAGE_BATCH_SLOTS; ++i) {
+            MessageBatch& batch = _messageBatches[i];
+            if (!_timers.fired(batch.timer) || batch.channelId == 0) continue;
+            if (_rest->rateLimited(batch.channelId) || !flushMessageBatch(batch)) {
+                _timers.schedule(batch.timer, now, DISCORD_TIMER_RETRY);
+            }
+        }
+
+        switch (_state) {
+            case ConnectionState::Disconnected:
+                return _timers.nextDeadline();
+            case ConnectionState::Backoff:
+                // The socket is deliberately not polled here, otherwise it would reconnect on its own.
+                if (_timers.fired(_backoffTimer)) {
+                    connect();
+                }
+                return _timers.nextDeadline();
+            default:
+                break;
         }
 
         _socket.loop();
         _online = _socket.isConnected();
-        if (!_online && !_gatewayURL.isEmpty()) {
-            // Clear gateway/resume URL cache
-            _gatewayURL.clear();
-            return;
+
+        // Reconnects requested from within the socket callback are carried out here, outside of it.
+        switch (_pendingReconnect) {
+            case PendingReconnect::None:
+                break;
+            case PendingReconnect::Resume:
+                scheduleReconnect(true, 0);
+                return _timers.nextDeadline();
+            case PendingReconnect::Identify:
+                // Discord asks for a random 1-5 second wait before identifying again after an invalid session.
+                scheduleReconnect(false, random(1000, 5001));
+                return _timers.nextDeadline();
+            case PendingReconnect::Failure:
+                if (_state != ConnectionState::Ready) {
+                    ++_reconnectStats.failures;
+                    ++_reconnectStats.consecutiveFailures;
+                }
+                scheduleReconnect(true, backoffDelay());
+                return _timers.nextDeadline();
+        }
+
+        if (_identifyQueued && _timers.fired(_identifyTimer)) {
+            if (_rest->claimIdentify(now)) {
+                _identifyQueued = false;
+                setState(ConnectionState::Identifying);
+                identify();
+            }
+            else {
+                _timers.schedule(_identifyTimer, now, DISCORD_TIMER_RETRY);
+            }
         }
 
-        if (_rateLimit && now - _lastRateReset > 60000) {
+        if (_timers.fired(_handshakeTimer)) {
+            // Other shards may hold the Identify slot for a while, so waiting for it does not count as a stalled
+            // handshake.
+            if (_identifyQueued) {
+                _timers.schedule(_handshakeTimer, now, DISCORD_HANDSHAKE_TIMEOUT);
+            }
+            else {
+#ifdef ESP32
+                log_w(DISCORD_LOG_PREFIX "Gateway handshake timed out.");
+#else
+                Serial.println(DISCORD_LOG_PREFIX "Gateway handshake timed out.");
+#endif
+                ++_reconnectStats.failures;
+                ++_reconnectStats.consecutiveFailures;
+                scheduleReconnect(true, backoffDelay());
+                return _timers.nextDeadline();
+            }
+        }
+
+        if (_timers.fired(_rateResetTimer)) {
             // Serial.print("[DISCORD] Rate limit reset. Sent last minute: ");
             // Serial.println(_eventsSent);
             _eventsSent = 0;
-            _lastRateReset = now;
-        }
-
-        if (_heartbeatInterval > 0 && _now > (_firstHeartbeat > 0 ? _lastHeartbeatSend + _firstHeartbeat : _lastHeartbeatSend + _heartbeatInterval)) {
-            heartbeat();
-            _firstHeartbeat = 0;
+            _timers.schedule(_rateResetTimer, now, 60000);
         }
 
-        if (_lastHeartbeatAck > _lastHeartbeatSend + (_heartbeatInterval / 2))
-        {
+        // If a client does not receive a heartbeat ACK between its attempts at sending heartbeats, the connection
+        // is failed or "zombied". Once the RTT estimate has settled, the ACK is given up on well before the next
+        // heartbeat is due so a dead link is noticed quickly.
+        if (_timers.fired(_heartbeatAckTimer)) {
 #ifdef ESP32
-            log_w(DISCORD_LOG_PREFIX "Heartbeat acknowledgement timeout!");
+            log_w(DISCORD_LOG_PREFIX "Heartbeat acknowledgement timeout! Reconnecting to resume.");
 #else
-            Serial.println(DISCORD_LOG_PREFIX "Heartbeat acknowledgement timeout!");
+            Serial.println(DISCORD_LOG_PREFIX "Heartbeat acknowledgement timeout! Reconnecting to resume.");
 #endif
-            logout();
+            scheduleReconnect(true, 0);
+            return _timers.nextDeadline();
+        }
+
+        // A heartbeat that went out re-arms the timer itself.
+        if (_timers.fired(_heartbeatTimer) && !heartbeat()) {
+            _timers.schedule(_heartbeatTimer, now, DISCORD_TIMER_RETRY);
         }
+
+        if (_presencePending && _state == ConnectionState::Ready && !_presenceTimer.armed()) {
+            sendPresence();
+            // Still pending means the rate window is full, try again shortly.
+            if (_presencePending) {
+                _timers.schedule(_presenceTimer, now, DISCORD_TIMER_RETRY);
+            }
+        }
+        return _timers.nextDeadline();
+    }
+
+    unsigned long Bot::heartbeatAckTimeout() const {
+        // Same shape as the TCP retransmission timeout: smoothed RTT plus four deviations.
+        unsigned long timeout = _heartbeatRTT > 0 ? _heartbeatRTT + 4 * _heartbeatRTTVar : _heartbeatInterval;
+        if (timeout < DISCORD_HEARTBEAT_ACK_MIN_TIMEOUT) timeout = DISCORD_HEARTBEAT_ACK_MIN_TIMEOUT;
+        if (timeout > _heartbeatInterval) timeout = _heartbeatInterval;
+        return timeout;
+    }
+
+    unsigned long Bot::backoffDelay() const {
+        // Capped exponential backoff with equal jitter: half the window is fixed, the other half random, so a fleet
+        // that lost Discord at the same moment spreads its reconnects out.
+        if (_reconnectStats.consecutiveFailures == 0) return 0;
+        uint32_t shift = _reconnectStats.consecutiveFailures - 1;
+        unsigned long window = shift >= 16 ? DISCORD_BACKOFF_MAX : DISCORD_BACKOFF_BASE * (1UL << shift);
+        if (window > DISCORD_BACKOFF_MAX) window = DISCORD_BACKOFF_MAX;
+        return window / 2 + random(0, window / 2 + 1);
+    }
+
+    void Bot::scheduleReconnect(bool resume, unsigned long delay) {
+        if (_state == ConnectionState::Ready) {
+            _disconnectedAt = _now;
+        }
+        // Drop the connection without a clean close so the session stays resumable on Discord's side.
+        _socket.disconnect();
+        _online = false;
+        stopHeartbeat();
+        _pendingReconnect = PendingReconnect::None;
+        if (!resume) {
+            _sessionId.clear();
+            _resumeURL.clear();
+        }
+        _reconnectStats.lastBackoff = delay;
+        setState(ConnectionState::Backoff);
+        _timers.schedule(_backoffTimer, _now, delay);
+        Serial.print(DISCORD_LOG_PREFIX "Reconnecting in (ms): ");
+        Serial.println(delay);
+    }
+
+    void Bot::setState(ConnectionState state) {
+        _state = state;
+        // Each step of the handshake gets the full timeout.
+        if (state == ConnectionState::Connecting || state == ConnectionState::Identifying ||
+            state == ConnectionState::Resuming) {
+            _timers.schedule(_handshakeTimer, _now, DISCORD_HANDSHAKE_TIMEOUT);
+        }
+        else {
+            _timers.cancel(_handshakeTimer);
+        }
+    }
+
+    void Bot::stopHeartbeat() {
+        _heartbeatInterval = 0;
+        _timers.cancel(_heartbeatTimer);
+        _timers.cancel(_heartbeatAckTimer);
     }
 
     void Bot::logout() {
         if (_socket.isConnected()) {
-            _socket.disconnect();
-            _online = false;
-            _sessionId.clear();
             Serial.println(DISCORD_LOG_PREFIX "Logout complete.");
         }
-        _https.end();
+        _socket.disconnect();
+        _online = false;
+        _sessionId.clear();
+        _resumeURL.clear();
+        stopHeartbeat();
+        _pendingReconnect = PendingReconnect::None;
+        _identifyQueued = false;
+        _timers.cancel(_identifyTimer);
+        _timers.cancel(_backoffTimer);
+        _timers.cancel(_rateResetTimer);
+        setState(ConnectionState::Disconnected);
+        // A shared connection stays open for the other bots.
+        if (_rest == &_ownRest) {
+            _rest->end();
+        }
+    }
+
+    bool Bot::requestGuildMembers(Snowflake guildId, const char* query, uint16_t limit, const char* nonce) {
+        StaticJsonDocument<256> doc;
+        doc[_op] = static_cast<int>(EventType::RequestGuildMembers);
+        JsonObject d = doc.createNestedObject(_d);
+        char id[DISCORD_SNOWFLAKE_DIGITS + 1];
+        guildId.format(id);
+        d["guild_id"] = id;
+        d["query"] = query ? query : "";
+        d["limit"] = limit;
+        if (nonce && *nonce) {
+            d["nonce"] = nonce;
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        return sendWS(payload.c_str(), payload.length());
+    }
+
+    bool Bot::requestGuildMembers(Snowflake guildId, const Snowflake* userIds, size_t count, const char* nonce) {
+        if (count == 0) return false;
+        if (count > 100) count = 100;
+
+        // Snowflakes are copied in as strings, so size the document for them.
+        DynamicJsonDocument doc(JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(count) +
+            (count + 1) * (DISCORD_SNOWFLAKE_DIGITS + 1) + DISCORD_MEMBERS_NONCE_LENGTH + 64);
+        doc[_op] = static_cast<int>(EventType::RequestGuildMembers);
+        JsonObject d = doc.createNestedObject(_d);
+        char id[DISCORD_SNOWFLAKE_DIGITS + 1];
+        guildId.format(id);
+        d["guild_id"] = static_cast<char*>(id);
+        JsonArray ids = d.createNestedArray("user_ids");
+        for (size_t i = 0; i < count; ++i) {
+            userIds[i].format(id);
+            ids.add(static_cast<char*>(id));
+        }
+        if (nonce && *nonce) {
+            d["nonce"] = nonce;
+        }
+        if (doc.overflowed()) return false;
+
+        String payload;
+        serializeJson(doc, payload);
+        return sendWS(payload.c_str(), payload.length());
+    }
+
+    void Bot::updatePresence(const Presence& presence) {
+        static const char* const statusNames[] = { "online", "dnd", "idle", "invisible", "offline" };
+
+        StaticJsonDocument<384> doc;
+        doc[_op] = 3;
+        JsonObject d = doc.createNestedObject(_d);
+        if (presence.since > 0) {
+            d["since"] = presence.since;
+        }
+        else {
+            d["since"] = nullptr;
+        }
+        JsonArray activities = d.createNestedArray("activities");
+        // A custom status is all state. Discord ignores its name but still requires one.
+        bool custom = presence.activityType == Presence::ActivityType::CUSTOM;
+        if (custom ? strlen(presence.activityState) > 0 : strlen(presence.activityName) > 0) {
+            JsonObject activity = activities.createNestedObject();
+            activity["name"] = custom && strlen(presence.activityName) == 0 ? "Custom Status" : presence.activityName;
+            activity["type"] = static_cast<int>(presence.activityType);
+            if (strlen(presence.activityState) > 0) {
+                activity["state"] = presence.activityState;
+            }
+            if (presence.activityType == Presence::ActivityType::STREAMING && strlen(presence.activityUrl) > 0) {
+                activity["url"] = presence.activityUrl;
+            }
+        }
+        d["status"] = statusNames[static_cast<int>(presence.status)];
+        d["afk"] = presence.afk;
+
+        if (_presencePending) {
+            _metrics.increment(Metrics::Counter::PresenceUpdatesCoalesced);
+        }
+        _presencePayload.clear();
+        serializeJson(doc, _presencePayload);
+        _presencePending = true;
+    }
+
+    void Bot::sendPresence() {
+        // Leave room in the rate window for heartbeats, the update stays pending until the window resets.
+        if (_rateLimit && _eventsSent + DISCORD_GATEWAY_RESERVE >= 120) return;
+        if (!sendWS(_presencePayload.c_str(), _presencePayload.length())) return;
+        _presencePending = false;
+        _timers.schedule(_presenceTimer, _now, DISCORD_PRESENCE_INTERVAL);
+#ifdef _DISCORD_CLIENT_DEBUG
+        Serial.print(DISCORD_LOG_PREFIX "Presence updated: ");
+        Serial.println(_presencePayload);
+#endif
     }
 
     void Bot::onEvent(const EventCallback& cb) {
@@ -124,41 +414,185 @@ namespace Discord {
     }
 
     inline void Bot::sendCommandResponse(const InteractionResponse& type, const StaticJsonDocument<512>& response) {
+        String json((char*)0);
+        json.reserve(512);
+        serializeJson(response, json);
+        Serial.println(json);
+        postInteractionCallback(json);
+    }
 
-#ifdef _DISCORD_CLIENT_DEBUG
-        unsigned long start = millis();
-#endif
+    bool Bot::postInteractionCallback(const String& json) {
+        unsigned long receivedAt = _interactionReceivedAt;
+        Metrics* metrics = &_metrics;
+
+        // Interactions received over HTTP are answered in the HTTP response.
+        if (_endpointResponse) {
+            *_endpointResponse = json;
+            _endpointResponse = nullptr;
+            metrics->interactionLatency().record(millis() - receivedAt);
+            return true;
+        }
 
-        String url(DISCORD_API_URI "/interactions/");
-        url.reserve(sizeof(uint64_t) + _interactionToken.length() + 11);
+        UrlBuilder<> url(DISCORD_API_URI "/interactions/");
         url += _interactionId;
         url += "/";
         url += _interactionToken;
         url += "/callback";
-
-        String json((char*)0);
-        json.reserve(512);
-        serializeJson(response, json);
-        Serial.println(json);
-        sendPostAsync<256>("POST", std::move(url), json, _botToken,
-#ifdef _DISCORD_CLIENT_DEBUG
-            [start](const StaticJsonDocument<256>& response) {
+        if (url.overflowed()) {
+#ifdef ESP32
+            log_e(DISCORD_LOG_PREFIX "[COMMAND] Interaction token too long for DISCORD_URL_LENGTH!");
 #else
-            [](const StaticJsonDocument<256>& response) {
+            Serial.println(DISCORD_LOG_PREFIX "[COMMAND] Interaction token too long for DISCORD_URL_LENGTH!");
 #endif
+            return false;
+        }
+
+        return sendPostAsync<256>("POST", url.c_str(), json, _botToken,
+            [receivedAt, metrics](const StaticJsonDocument<256>& response) {
+                unsigned long end = millis();
+                metrics->interactionLatency().record(end - receivedAt);
 #ifdef ESP32
                 log_i(DISCORD_LOG_PREFIX "[COMMAND] Response sent.");
 #else
                 Serial.println("[COMMAND] Response sent.");
 #endif
 #ifdef _DISCORD_CLIENT_DEBUG
-                unsigned long end = millis();
                 Serial.print("Time to respond (ms): ");
-                Serial.println(end - start);
+                Serial.println(end - receivedAt);
 #endif
-            }, & _httpsMtx);
+            }, &_restScheduler, 0, RestPriority::Interaction);
+    }
 
-        return;
+    void Bot::onAutocomplete(const AutocompleteCallback& cb) {
+        _autocompleteCallback = cb;
+    }
+
+    AutocompleteResponse& Bot::autocompleteResponse() {
+        _autocompleteSlot.clear();
+        return _autocompleteSlot;
+    }
+
+    bool Bot::sendAutocompleteResponse() {
+        if (_interactionId == 0 || _interactionToken.isEmpty()) {
+#ifdef ESP32
+            log_e(DISCORD_LOG_PREFIX "[COMMAND] No token or id available!");
+#else
+            Serial.println(DISCORD_LOG_PREFIX "[COMMAND] No token or id available!");
+#endif
+            return false;
+        }
+        return postInteractionCallback(String(_autocompleteSlot.json()));
+    }
+
+    bool Bot::sendAutocompleteResponse(const AutocompleteChoice* choices, size_t count) {
+        autocompleteResponse().add(choices, count);
+        return sendAutocompleteResponse();
+    }
+
+    void Bot::handleInteraction(JsonObject interaction, unsigned long receivedAt) {
+        _interactionToken.reserve(256);
+        _interactionToken = interaction["token"].as<const char*>();
+        _interactionId = Snowflake(interaction["id"].as<const char*>());
+        _interactionReceivedAt = receivedAt;
+        _timers.schedule(_interactionTimer, receivedAt, DISCORD_INTERACTION_TOKEN_LIFETIME);
+
+        uint8_t type = interaction["type"];
+        if (!admitInteraction(type)) return;
+
+        // Components and modals have no name, they are identified by their custom_id instead.
+        bool component = type == 3 || type == 5;
+        const char* interactionName = component ?
+            interaction["data"]["custom_id"].as<const char*>() : interaction["data"]["name"].as<const char*>();
+        if (component) {
+            Serial.print(DISCORD_LOG_PREFIX "[COMMAND] Component used: ");
+        }
+        else {
+            Serial.print(DISCORD_LOG_PREFIX "[COMMAND] Command ");
+            Serial.print(interaction["data"]["id"].as<const char*>());
+            Serial.print(" used: ");
+        }
+        Serial.println(interactionName);
+
+        // APPLICATION_COMMAND_AUTOCOMPLETE
+        if (_autocompleteCallback != nullptr && type == 4) {
+            dispatchAutocomplete(interaction);
+        }
+        // MESSAGE_COMPONENT and MODAL_SUBMIT, unrouted ones fall through to the interaction callback.
+        else if (component && _components.dispatch(interactionName, interaction)) {
+            // Answered by its route
+        }
+        else if (_interactionCallback != nullptr) {
+            _interactionCallback(interactionName, interaction);
+        }
+        else {
+#ifdef _DISCORD_CLIENT_DEBUG
+            Serial.println(DISCORD_LOG_PREFIX "No interaction callback was found, no response given.");
+#endif
+        }
+    }
+
+    bool Bot::admitInteraction(uint8_t type) {
+        AdmissionController::Pressure pressure;
+        AdmissionController::sampleMemory(pressure);
+        pressure.restQueue = _metrics.gauge(Metrics::Gauge::RestQueueDepth);
+        pressure.pendingInteractions = _metrics.gauge(Metrics::Gauge::PendingInteractions);
+
+        switch (_admission.decide(pressure)) {
+            case AdmissionController::Decision::Admit:
+                _metrics.increment(Metrics::Counter::InteractionsAdmitted);
+                return true;
+            case AdmissionController::Decision::Busy:
+                _metrics.increment(Metrics::Counter::InteractionsShed);
+#ifdef ESP32
+                log_w(DISCORD_LOG_PREFIX "[COMMAND] Under load, sending the busy reply.");
+#else
+                Serial.println(DISCORD_LOG_PREFIX "[COMMAND] Under load, sending the busy reply.");
+#endif
+                postInteractionCallback(String(AdmissionController::busyResponse(type)));
+                return false;
+            case AdmissionController::Decision::Drop:
+                break;
+        }
+        _metrics.increment(Metrics::Counter::InteractionsDropped);
+#ifdef ESP32
+        log_e(DISCORD_LOG_PREFIX "[COMMAND] Out of memory, interaction dropped.");
+#else
+        Serial.println(DISCORD_LOG_PREFIX "[COMMAND] Out of memory, interaction dropped.");
+#endif
+        return false;
+    }
+
+    bool Bot::answerEndpointInteraction(JsonObject interaction, unsigned long receivedAt, String& response) {
+        // Without a Gateway session, the application id is only known from the interactions themselves.
+        if (_applicationId == 0) {
+            _applicationId = Snowflake(interaction["application_id"].as<const char*>());
+        }
+        pushEvent(EventType::InteractionCreate);
+        _endpointResponse = &response;
+        handleInteraction(interaction, receivedAt);
+        bool answered = _endpointResponse == nullptr;
+        _endpointResponse = nullptr;
+        return answered;
+    }
+
+    void Bot::dispatchAutocomplete(JsonObject interaction) {
+        // The focused option may be nested inside a subcommand or subcommand group.
+        JsonArray options = interaction["data"]["options"];
+        for (uint8_t depth = 0; depth < 3 && !options.isNull(); ++depth) {
+            JsonArray nested;
+            for (JsonObject option : options) {
+                if (option["focused"].as<bool>()) {
+                    // Numeric options are typed as numbers but may be partial, pass the raw text either way.
+                    String value = option["value"].as<String>();
+                    _autocompleteCallback(interaction["data"]["name"], option["name"], value.c_str(), interaction);
+                    return;
+                }
+                if (option.containsKey("options")) {
+                    nested = option["options"];
+                }
+            }
+            options = nested;
+        }
     }
 
     void Bot::sendCommandResponse(const InteractionResponse & type, const MessageResponse & response) {
@@ -173,29 +607,16 @@ namespace Discord {
         StaticJsonDocument<512> doc;
         doc["type"] = static_cast<unsigned short>(type);
         JsonObject data = doc.createNestedObject("data");
+        serializeMessage(response, data);
+        // Overload is handled before the interaction reaches the callback, see admitInteraction().
+        sendCommandResponse(type, doc);
+    }
+
+    void Bot::serializeMessage(const MessageResponse& response, JsonObject data) {
         if (response.tts) {
             data["tts"] = true;
         }
-
-        /*
-        This theory and its following safeguard is currently untested.
-
-        Buffer safety: If too many simultaneous interactions come in, the ESP32 might have trouble responding to all
-        of the interactions sequentially within their allotted 3-second window due to not having enough heap space to
-        queue and send responses. If that happens, a warning message is appended to the last possible response
-        to notify users the bot is being overloaded, and the bot will fail to respond to subsequent interactions until
-        the existing responses have been sent out.
-        */
-        if (esp_get_free_heap_size() > 2 * (4 * 1024 + 512)) {
-            data["content"] = response.content;
-        }
-        else {
-            String msg((char*)0);
-            msg.reserve(strlen(response.content) + 102);
-            msg += response.content;
-            msg += "\n\n**Warning: Not enough memory for further processing. Please wait before sending further commands.**";
-            data["content"] = msg;
-        }
+        data["content"] = response.content;
 
         if (response.enableAllowedMentions) {
             JsonObject allowedMentions = data.createNestedObject("allowed_mentions");
@@ -223,8 +644,99 @@ namespace Discord {
             Serial.print("Flags: ");
             Serial.println(static_cast<uint8_t>(response.flags));
         }
+    }
 
-        sendCommandResponse(type, doc);
+    bool Bot::createMessage(Snowflake channelId, const MessageResponse& message) {
+        if (_rest->rateLimited(channelId)) {
+#ifdef ESP32
+            log_w(DISCORD_LOG_PREFIX "Channel %llu is rate limited, message not sent.", channelId.value);
+#else
+            Serial.println(DISCORD_LOG_PREFIX "Channel is rate limited, message not sent.");
+#endif
+            _metrics.increment(Metrics::Counter::RestRequestsDropped);
+            return false;
+        }
+
+        StaticJsonDocument<512> doc;
+        serializeMessage(message, doc.to<JsonObject>());
+
+        UrlBuilder<> url(DISCORD_API_URI "/channels/");
+        url += channelId;
+        url += "/messages";
+
+        String json((char*)0);
+        json.reserve(512);
+        serializeJson(doc, json);
+        return sendPostAsync<256>("POST", url.c_str(), json, _botToken, nullptr, &_restScheduler, channelId, RestPriority::Message);
+    }
+
+    bool Bot::executeWebhook(Snowflake webhookId, const char* webhookToken, const MessageResponse& message) {
+        if (_rest->rateLimited(webhookId)) {
+            _metrics.increment(Metrics::Counter::RestRequestsDropped);
+            return false;
+        }
+
+        StaticJsonDocument<512> doc;
+        serializeMessage(message, doc.to<JsonObject>());
+
+        UrlBuilder<> url(DISCORD_API_URI "/webhooks/");
+        url += webhookId;
+        url += "/";
+        url += webhookToken;
+
+        String json((char*)0);
+        json.reserve(512);
+        serializeJson(doc, json);
+        // The webhook token in the URL authorises the request, no bot token needed.
+        if (url.overflowed()) return false;
+        return sendPostAsync<256>("POST", url.c_str(), json, "", nullptr, &_restScheduler, webhookId, RestPriority::Message);
+    }
+
+    void Bot::queueMessage(Snowflake channelId, const char* line) {
+        size_t lineLength = strlen(line);
+        MessageBatch* batch = nullptr;
+        for (size_t i = 0; i < DISCORD_MESSAGE_BATCH_SLOTS; ++i) {
+            if (_messageBatches[i].channelId == channelId) {
+                batch = &_messageBatches[i];
+                break;
+            }
+            if (!batch && _messageBatches[i].channelId == 0) {
+                batch = &_messageBatches[i];
+            }
+        }
+
+        if (!batch) {
+            // Every batch slot is taken by another channel, send the line on its own.
+            MessageResponse message;
+            message.content = line;
+            createMessage(channelId, message);
+            return;
+        }
+
+        // Discord caps message content at 2000 characters.
+        if (batch->channelId == channelId && batch->content.length() + 1 + lineLength > 2000 &&
+            !flushMessageBatch(*batch)) {
+            _metrics.increment(Metrics::Counter::RestRequestsDropped);
+            return;
+        }
+        if (batch->channelId == 0) {
+            batch->channelId = channelId;
+            _timers.schedule(batch->timer, _now, DISCORD_MESSAGE_BATCH_WINDOW);
+            batch->content.reserve(256);
+        }
+        if (!batch->content.isEmpty()) {
+            batch->content += "\n";
+        }
+        batch->content += line;
+    }
+
+    bool Bot::flushMessageBatch(MessageBatch& batch) {
+        MessageResponse message;
+        message.content = batch.content.c_str();
+        if (!createMessage(batch.channelId, message)) return false;
+        batch.channelId = 0;
+        batch.content.clear();
+        return true;
     }
 
     void Bot::onWebSocketEvents(WStype_t type, uint8_t * payload, size_t length) {
@@ -241,6 +753,11 @@ namespace Discord {
             case WStype_DISCONNECTED:
                 Serial.println(DISCORD_LOG_PREFIX "Connection closed.");
                 _online = false;
+                // An explicit Reconnect or InvalidSession already decided how to come back.
+                if (_pendingReconnect == PendingReconnect::None &&
+                    _state != ConnectionState::Disconnected && _state != ConnectionState::Backoff) {
+                    _pendingReconnect = PendingReconnect::Failure;
+                }
                 break;
             case WStype_CONNECTED:
                 Serial.println(DISCORD_LOG_PREFIX "Connected to gateway.");
@@ -254,9 +771,29 @@ namespace Discord {
                 Serial.println(DISCORD_LOG_PREFIX "Message received.");
 #endif
 #endif
-                parseMessage(payload, length);
+            {
+#ifdef DISCORD_FAULT_INJECTION
+                applyReadFaults(length);
+#endif
+                // Parsing terminates strings in place, record the frame before it is touched.
+                recordFrame(FlightRecorder::Direction::Received, payload, length, payload, length);
+                unsigned long start = micros();
+                Metrics::Frame frame = parseMessage(payload, length);
+                _metrics.parseTime(frame).record(micros() - start);
                 break;
+            }
             case WStype_BIN:
+#ifdef DISCORD_GATEWAY_ETF
+            {
+#ifdef DISCORD_FAULT_INJECTION
+                applyReadFaults(length);
+#endif
+                recordFrame(FlightRecorder::Direction::Received, payload, length, nullptr, 0);
+                unsigned long start = micros();
+                Metrics::Frame frame = parseMessage(payload, length);
+                _metrics.parseTime(frame).record(micros() - start);
+            }
+#endif
                 break;
             case WStype_FRAGMENT_TEXT_START:
                 break;
@@ -275,27 +812,134 @@ namespace Discord {
         }
     }
 
+#ifdef DISCORD_FAULT_INJECTION
+    void Bot::injectFault(Fault fault, uint32_t amount) {
+        _faultReport = FaultReport();
+        _faultReport.fault = fault;
+        _faultReport.injectedAt = millis();
+        switch (fault) {
+            case Fault::DropConnection:
+                // The socket reports the disconnect back through onWebSocketEvents, as for a real loss.
+                _socket.disconnect();
+                break;
+            case Fault::Reconnect:
+                injectFrame("{\"op\":7,\"d\":null}");
+                break;
+            case Fault::InvalidSession:
+                injectFrame("{\"op\":9,\"d\":false}");
+                break;
+            case Fault::InvalidSessionResumable:
+                injectFrame("{\"op\":9,\"d\":true}");
+                break;
+            case Fault::MissHeartbeatAcks:
+                _acksToMiss = amount;
+                break;
+            case Fault::SlowRead:
+                _slowReads = amount;
+                break;
+            case Fault::PartialFrame:
+                _partialFrames = amount;
+                break;
+        }
+    }
+
+    void Bot::injectFrame(const char* json) {
+        size_t length = strlen(json);
+        uint8_t frame[32];
+#ifdef DISCORD_GATEWAY_ETF
+        StaticJsonDocument<64> doc;
+        if (deserializeJson(doc, json, length)) return;
+        length = serializeEtf(doc.as<JsonVariantConst>(), frame, sizeof(frame));
+        onWebSocketEvents(WStype_BIN, frame, length);
+#else
+        // Frames are parsed in place, so hand over a writable copy.
+        if (length > sizeof(frame)) return;
+        memcpy(frame, json, length);
+        onWebSocketEvents(WStype_TEXT, frame, length);
+#endif
+    }
+
+    void Bot::applyReadFaults(size_t& length) {
+        if (_slowReads > 0) {
+            --_slowReads;
+            delay(DISCORD_FAULT_SLOW_READ);
+        }
+        if (_partialFrames > 0) {
+            --_partialFrames;
+            length /= 2;
+        }
+    }
+#endif
+
     void Bot::pushEvent(Event const& event) {
-        if (_outerCallback != nullptr && _eventQueueIndex < DISCORD_MAX_EVENTS) {
+        if (_outerCallback == nullptr) return;
+        if (_eventQueueIndex < DISCORD_MAX_EVENTS) {
             _eventQueue[_eventQueueIndex++] = event;
+            _metrics.setGauge(Metrics::Gauge::EventQueueDepth, _eventQueueIndex);
+        }
+        else {
+            _metrics.increment(Metrics::Counter::EventsDropped);
         }
     }
 
     void Bot::pushEvent(EventType type) {
-        if (_outerCallback != nullptr && _eventQueueIndex < DISCORD_MAX_EVENTS) {
+        if (_outerCallback == nullptr) return;
+        if (_eventQueueIndex < DISCORD_MAX_EVENTS) {
             _eventQueue[_eventQueueIndex++].type = type;
+            _metrics.setGauge(Metrics::Gauge::EventQueueDepth, _eventQueueIndex);
+        }
+        else {
+            _metrics.increment(Metrics::Counter::EventsDropped);
         }
     }
 
-    void Bot::parseMessage(uint8_t * payload, size_t length) {
+    Metrics::Frame Bot::parseMessage(uint8_t * payload, size_t length) {
+        unsigned long receivedAt = millis();
+        // GUILD_CREATE carries every channel, role and member of a guild, far more than the usual document holds.
+        // With a cache attached, only the parts it keeps are parsed, into a larger document.
+        // READY lists every guild and the bot's user as well, of which only the session details are kept.
+#ifdef DISCORD_GATEWAY_ETF
+        // ETF has no key/value punctuation to anchor on, the type name alone is distinctive enough.
+        bool guildCreate = _cache && containsToken(payload, length, "GUILD_CREATE");
+        bool ready = !guildCreate && _state == ConnectionState::Identifying && containsToken(payload, length, "READY");
+        PlacedJsonDocument doc(guildCreate ? DISCORD_CACHE_PARSE_SIZE : 2048,
+            PlacedAllocator(guildCreate ? BufferKind::LargeFrame : BufferKind::GatewayFrame));
+        JsonDocument* filter = guildCreate ? &guildCreateFilter() : ready ? &readyFilter() : nullptr;
+        DeserializationError e = filter ?
+            deserializeEtf(doc, payload, length, filter->as<JsonVariantConst>()) :
+            deserializeEtf(doc, payload, length);
+#else
+        // Most frames can be handled from their op, s and t alone. Only parse the ones whose data is used.
+        FrameHead head;
+        bool scanned = scanFrameHead(payload, length, head);
+        if (scanned) {
+            Metrics::Frame frame;
+            if (parseFrameHead(head, payload, length, receivedAt, frame)) {
+                _metrics.increment(Metrics::Counter::FramesParsedLazily);
+                return frame;
+            }
+        }
+        bool guildCreate = _cache && containsToken(payload, length, "\"t\":\"GUILD_CREATE\"");
+        bool ready = scanned && head.op == static_cast<int>(EventType::Dispatch) &&
+            dispatchEventType(head.t, head.tLength) == EventType::Ready;
         //Deserialize the first part of our payload
-        DynamicJsonDocument doc(2048);
-        DeserializationError e = deserializeJson(doc, payload, length);
+        PlacedJsonDocument doc(guildCreate ? DISCORD_CACHE_PARSE_SIZE : 2048,
+            PlacedAllocator(guildCreate ? BufferKind::LargeFrame : BufferKind::GatewayFrame));
+        JsonDocument* filter = guildCreate ? &guildCreateFilter() : ready ? &readyFilter() : nullptr;
+        DeserializationError e = filter ?
+            deserializeJson(doc, payload, length, DeserializationOption::Filter(*filter)) :
+            deserializeJson(doc, payload, length);
+#endif
         if (e) {
-            Serial.print("Payload deserializeJson() call failed with code ");
+            Serial.print("Payload deserialization failed with code ");
             Serial.println(e.c_str());
+            _metrics.increment(Metrics::Counter::FramesDiscarded);
+#ifndef DISCORD_GATEWAY_ETF
+            // The frame is lost, but later heartbeats and resumes must still count it.
+            if (scanned && head.hasSequence) trackSequence(head.s);
+#endif
             // Handle the error here, don't pass it upward.
-            return;
+            return Metrics::Frame::Control;
         }
 
 #ifdef _DISCORD_CLIENT_DEBUG
@@ -308,67 +952,59 @@ namespace Discord {
             case EventType::Dispatch:
                 // Dispatch (opcode 0) events are the most common type of event.
                 // Most Gateway events which represent actions taking place in a guild will be sent as Dispatch events.
-                _lastSocketSequence = doc["s"];
+                trackSequence(doc["s"]);
 
                 pushEvent(EventType::Dispatch);
 
                 if (doc[_t] == "READY") {
                     _ready = true;
                     _sessionId = doc[_d]["session_id"].as<const char*>();
-                    _gatewayURL = doc[_d]["resume_gateway_url"].as<const char*>() + 6;
-                    _applicationId = doc[_d]["application"]["id"];
+                    _resumePayload.clear();
+                    _resumeURL = doc[_d]["resume_gateway_url"].as<const char*>() + 6;
+                    _applicationId = Snowflake(doc[_d]["application"]["id"].as<const char*>());
                     Serial.print(DISCORD_LOG_PREFIX "Gateway URL set to resume on ");
-                    Serial.println(_gatewayURL);
+                    Serial.println(_resumeURL);
+                    ++_reconnectStats.identifies;
+                    connectionEstablished(false);
+                    // A fresh session starts with the default presence, send ours again.
+                    if (!_presencePayload.isEmpty()) {
+                        _presencePending = true;
+                    }
                     Serial.println(DISCORD_LOG_PREFIX "Ready to comply.");
                     pushEvent(EventType::Ready);
-                    return;
+                    return Metrics::Frame::Ready;
                 }
                 else if (doc[_t] == "RESUMED") {
-                    Serial.println(DISCORD_LOG_PREFIX "Session resumed.");
-                    if (_outerCallback != nullptr) {
-                        pushEvent(EventType::Resumed);
-                    }
-                    return;
+                    sessionResumed();
+                    return Metrics::Frame::Ready;
                 }
-                else if (doc[_t] == "INTERACTION_CREATE") {
-                    _interactionToken.reserve(256);
-                    _interactionToken = doc[_d]["token"].as<const char*>();
-                    _interactionId = doc[_d]["id"];
-
-                    const char* interactionName = doc[_d]["data"]["name"];
-                    Serial.print(DISCORD_LOG_PREFIX "[COMMAND] Command ");
-                    Serial.print(doc[_d]["data"]["id"].as<const char*>());
-                    Serial.print(" used: ");
-                    Serial.println(interactionName);
-
+                else if (subscribed(EventFamily::Interactions) && doc[_t] == "INTERACTION_CREATE") {
                     pushEvent(EventType::InteractionCreate);
-
-                    if (_interactionCallback != nullptr) {
-                        _interactionCallback(interactionName, doc[_d].as<JsonObject>());
-                    }
-                    else {
-#ifdef _DISCORD_CLIENT_DEBUG
-                        Serial.println(DISCORD_LOG_PREFIX "No interaction callback was found, no response given.");
-#endif
-                    }
-                    return;
+                    handleInteraction(doc[_d].as<JsonObject>(), receivedAt);
+                    return Metrics::Frame::Interaction;
                 }
                 // Privileged intent MESSAGE_CONTENT required to see message contents outside of DMs and mentions.
-                else if (doc[_t] == "MESSAGE_CREATE") {
-                    //Ignore our own messages
-                    if (doc[_d]["author"]["id"].as<uint64_t>() == _applicationId) return;
-                    Serial.println(DISCORD_LOG_PREFIX "New chat message received.");
-                    pushEvent(EventType::MessageCreate);
-                    return;
+                else if (subscribed(EventFamily::Messages) && doc[_t] == "MESSAGE_CREATE") {
+                    return messageCreated(doc[_d].as<JsonObject>());
                 }
-                pushEvent(static_cast<EventType>(doc[_op].as<int>()));
-                return;
-
+                if ((subscribed(EventFamily::Guilds) || subscribed(EventFamily::Channels)) && _cache) {
+                    _cache->update(doc[_t], doc[_d]);
+                }
+                {
+                    const char* type = doc[_t] | "";
+                    EventType event = dispatchEventType(type, strlen(type));
 #ifdef _DISCORD_CLIENT_DEBUG
-                Serial.print(DISCORD_LOG_PREFIX "Unmanaged dispatch event type: ");
-                Serial.println(doc["t"].as<const char*>());
+                    if (event == EventType::Dispatch) {
+                        Serial.print(DISCORD_LOG_PREFIX "Unmanaged dispatch event type: ");
+                        Serial.println(type);
+                    }
 #endif
-                return;
+                    // The ETF path has no pre-scan, so unsubscribed families can still get here.
+                    if (event != EventType::Dispatch && !skipDispatch(event)) {
+                        pushEvent(event);
+                    }
+                }
+                return Metrics::Frame::Dispatch;
             case EventType::Heartbeat:
                 heartbeat();
                 break;
@@ -381,8 +1017,8 @@ namespace Discord {
             case EventType::Resume:
                 break;
             case EventType::Reconnect:
-                logout();
-                login(_botToken, _intents);
+                // Discord wants us to reconnect and resume, which is done from update().
+                _pendingReconnect = PendingReconnect::Resume;
                 break;
             case EventType::RequestGuildMembers:
                 break;
@@ -395,21 +1031,18 @@ namespace Discord {
                 if (doc[_d].as<bool>() == false) {
 #ifdef _DISCORD_CLIENT_DEBUG 
 #ifdef ESP32
-                    log_v(DISCORD_LOG_PREFIX "Clearing Gateway URL and session id.");
+                    log_v(DISCORD_LOG_PREFIX "Clearing session id.");
 #else
-                    Serial.println(DISCORD_LOG_PREFIX "Clearing Gateway URL and session id.");
+                    Serial.println(DISCORD_LOG_PREFIX "Clearing session id.");
 #endif
 #endif
-                    _gatewayURL.clear();
-                    _sessionId.clear();
-                    logout();
-                    login(_botToken, _intents);
+                    _pendingReconnect = PendingReconnect::Identify;
                 }
                 else {
-                    logout();
+                    _pendingReconnect = PendingReconnect::Resume;
                 }
                 break;
-            case EventType::Hello:
+            case EventType::Hello: {
                 _heartbeatInterval = doc[_d]["heartbeat_interval"];
 #ifdef _DISCORD_CLIENT_DEBUG 
                 Serial.print(DISCORD_LOG_PREFIX "Heartbeat interval (ms): ");
@@ -417,83 +1050,413 @@ namespace Discord {
 #endif
                 // Jitter is an offset value between 0 and heartbeat_interval that is meant to prevent too many clients 
                 // from reconnecting at the exact same time (which could cause an influx of traffic).
-                _firstHeartbeat = (random(0, 50) / 100.0f) * _heartbeatInterval;
+                unsigned long firstHeartbeat = (random(0, 50) / 100.0f) * _heartbeatInterval;
 #ifdef _DISCORD_CLIENT_DEBUG 
                 Serial.print(DISCORD_LOG_PREFIX "First heartbeat (ms):");
-                Serial.println(_firstHeartbeat);
+                Serial.println(firstHeartbeat);
 #endif
+                _timers.schedule(_heartbeatTimer, _now, firstHeartbeat);
+                _timers.cancel(_heartbeatAckTimer);
+                _timers.schedule(_rateResetTimer, _now, 60000);
+
                 if (_sessionId.isEmpty()) {
-                    identify();
+                    if (_rest->claimIdentify(_now)) {
+                        setState(ConnectionState::Identifying);
+                        identify();
+                    }
+                    else {
+                        _identifyQueued = true;
+                        _timers.schedule(_identifyTimer, _now, DISCORD_TIMER_RETRY);
+                    }
                 }
                 else {
+                    setState(ConnectionState::Resuming);
                     resume();
                 }
 
-                _lastHeartbeatSend = _now;
-                _lastHeartbeatAck = _now;
-                _lastRateReset = _now;
-
                 pushEvent(EventType::Hello);
                 break;
+            }
             case EventType::HeartbeatAck:
-                _lastHeartbeatAck = _now;
+                heartbeatAcknowledged(receivedAt);
+                break;
+            default:
+                break;
+        }
+        return Metrics::Frame::Control;
+    }
+
+    bool Bot::parseFrameHead(const FrameHead& head, uint8_t* payload, size_t length, unsigned long receivedAt,
+        Metrics::Frame& frame) {
+        frame = Metrics::Frame::Control;
+        switch (static_cast<EventType>(head.op)) {
+            case EventType::HeartbeatAck:
+                heartbeatAcknowledged(receivedAt);
+                return true;
+            case EventType::Heartbeat:
+                heartbeat();
+                return true;
+            case EventType::Reconnect:
+                _pendingReconnect = PendingReconnect::Resume;
+                return true;
+            case EventType::Dispatch:
+                break;
+            default:
+                // Hello and InvalidSession need their data, and are rare enough to parse in full.
+                return false;
+        }
+
+        EventType type = dispatchEventType(head.t, head.tLength);
+        frame = Metrics::Frame::Dispatch;
+        if (skipDispatch(type)) {
+            // Nobody handles it, but the sequence number still has to advance for heartbeats and resumes.
+            if (head.hasSequence) trackSequence(head.s);
+            _metrics.increment(Metrics::Counter::DispatchesSkipped);
+            return true;
+        }
+
+        switch (type) {
+            case EventType::Ready:
+            case EventType::InteractionCreate:
+                return false;
+            case EventType::Resumed:
+                if (head.hasSequence) trackSequence(head.s);
+                pushEvent(EventType::Dispatch);
+                sessionResumed();
+                frame = Metrics::Frame::Ready;
+                return true;
+            case EventType::MessageCreate: {
+                if (_prefixCommands) {
+                    // Commands need the content. It is parsed in place and handed out as views, so this parse
+                    // consumes the frame whether or not it succeeds.
+                    static StaticJsonDocument<192> commandFilter;
+                    if (commandFilter.isNull()) {
+                        JsonObject d = commandFilter.createNestedObject(_d);
+                        d["id"] = true;
+                        d["channel_id"] = true;
+                        d["guild_id"] = true;
+                        d["content"] = true;
+                        d["author"]["id"] = true;
+                        d["author"]["bot"] = true;
+                    }
+                    // The frame is consumed either way, so its sequence counts even if it cannot be parsed.
+                    if (head.hasSequence) trackSequence(head.s);
+                    StaticJsonDocument<256> doc;
+                    if (deserializeJson(doc, payload, length, DeserializationOption::Filter(commandFilter))) {
+                        _metrics.increment(Metrics::Counter::FramesDiscarded);
+                        return true;
+                    }
+                    pushEvent(EventType::Dispatch);
+                    frame = messageCreated(doc[_d].as<JsonObject>());
+                    return true;
+                }
+                // Only the author is needed, to drop our own messages.
+                static StaticJsonDocument<64> filter;
+                if (filter.isNull()) {
+                    filter[_d]["author"]["id"] = true;
+                }
+                StaticJsonDocument<128> doc;
+                // Read as const so nothing is unescaped in place, the payload may still need a full parse.
+                if (deserializeJson(doc, reinterpret_cast<const char*>(payload), length,
+                    DeserializationOption::Filter(filter))) return false;
+                if (head.hasSequence) trackSequence(head.s);
+                pushEvent(EventType::Dispatch);
+                frame = messageCreated(doc[_d].as<JsonObject>());
+                return true;
+            }
+            case EventType::GuildMembersChunk:
+                // Chunks can hold up to 1000 members, far too many to parse at once. Stream them instead.
+                if (_guildMemberCallback != nullptr) {
+                    MembersChunk chunk;
+                    if (!streamMembersChunk(payload, length, chunk, _guildMemberCallback)) {
+                        _metrics.increment(Metrics::Counter::FramesDiscarded);
+                    }
+                    if (head.hasSequence) trackSequence(head.s);
+                    pushEvent(EventType::Dispatch);
+                    pushEvent(EventType::GuildMembersChunk);
+                    return true;
+                }
+                // fall through
+            default:
+                // The cache reads the data of the families it tracks.
+                if (_cache && (eventFamily(type) == EventFamily::Guilds || eventFamily(type) == EventFamily::Channels)) {
+                    return false;
+                }
+                if (head.hasSequence) trackSequence(head.s);
+                pushEvent(EventType::Dispatch);
+                if (type != EventType::Dispatch) {
+                    pushEvent(type);
+                }
+                return true;
+        }
+    }
+
+    void Bot::heartbeatAcknowledged(unsigned long receivedAt) {
+#ifdef DISCORD_FAULT_INJECTION
+        if (_acksToMiss > 0) {
+            --_acksToMiss;
+            return;
+        }
+#endif
+        _timers.cancel(_heartbeatAckTimer);
+        if (_heartbeatSentAt > 0) {
+            unsigned long rtt = receivedAt - _heartbeatSentAt;
+            _metrics.heartbeatRoundTrip().record(rtt);
+            // Smoothed RTT and mean deviation, RFC 6298 style with gains of 1/8 and 1/4.
+            if (_heartbeatRTT == 0) {
+                _heartbeatRTT = rtt;
+                _heartbeatRTTVar = rtt / 2;
+            }
+            else {
+                unsigned long deviation = rtt > _heartbeatRTT ? rtt - _heartbeatRTT : _heartbeatRTT - rtt;
+                _heartbeatRTTVar = (3 * _heartbeatRTTVar + deviation) / 4;
+                _heartbeatRTT = (7 * _heartbeatRTT + rtt) / 8;
+            }
+            _heartbeatSentAt = 0;
+        }
 #ifdef _DISCORD_CLIENT_DEBUG 
 #ifdef ESP32
-                log_v(DISCORD_LOG_PREFIX "Heartbeat acknowledged.");
+        log_v(DISCORD_LOG_PREFIX "Heartbeat acknowledged.");
 #else
-                Serial.println(DISCORD_LOG_PREFIX "Heartbeat acknowledged.");
+        Serial.println(DISCORD_LOG_PREFIX "Heartbeat acknowledged.");
 #endif
 #endif
-                break;
-            default:
-                break;
+    }
+
+    void Bot::trackSequence(unsigned int sequence) {
+        // Sequence numbers restart with each session, only a jump forward means dispatches went missing.
+        if (_lastSocketSequence > 0 && sequence > _lastSocketSequence + 1) {
+            uint32_t missed = sequence - _lastSocketSequence - 1;
+            _metrics.increment(Metrics::Counter::EventsMissed, missed);
+#ifdef DISCORD_FAULT_INJECTION
+            if (_faultReport.injectedAt > 0) {
+                _faultReport.missedEvents += missed;
+            }
+#endif
+        }
+        _lastSocketSequence = sequence;
+    }
+
+    void Bot::sessionResumed() {
+        Serial.println(DISCORD_LOG_PREFIX "Session resumed.");
+        ++_reconnectStats.resumes;
+        connectionEstablished(true);
+        if (_outerCallback != nullptr) {
+            pushEvent(EventType::Resumed);
+        }
+    }
+
+    Metrics::Frame Bot::messageCreated(JsonObject message) {
+        //Ignore our own messages
+        if (Snowflake(message["author"]["id"].as<const char*>()) == _applicationId) return Metrics::Frame::Message;
+        Serial.println(DISCORD_LOG_PREFIX "New chat message received.");
+        pushEvent(EventType::MessageCreate);
+        if (_prefixCommands && !message["author"]["bot"].as<bool>()) {
+            _prefixCommands->dispatch(message["content"], message);
+        }
+        return Metrics::Frame::Message;
+    }
+
+    void Bot::connectionEstablished(bool resumed) {
+        if (_reconnectStats.attempts > 1 && _disconnectedAt > 0) {
+            _reconnectStats.lastDowntime = _now - _disconnectedAt;
+            _metrics.recoveryTime().record(_reconnectStats.lastDowntime);
+        }
+        // A fresh session after an earlier one starts over, whatever was dispatched in between is gone.
+        if (!resumed && _reconnectStats.identifies > 1) {
+            _metrics.increment(Metrics::Counter::SessionsLost);
+        }
+#ifdef DISCORD_FAULT_INJECTION
+        if (_faultReport.injectedAt > 0 && !_faultReport.recovered) {
+            _faultReport.recovered = true;
+            _faultReport.resumed = resumed;
+            _faultReport.recoveryTime = millis() - _faultReport.injectedAt;
+        }
+#endif
+        _disconnectedAt = 0;
+        _reconnectStats.consecutiveFailures = 0;
+        setState(ConnectionState::Ready);
+    }
+
+    bool Bot::containsToken(const uint8_t* payload, size_t length, const char* token) {
+        size_t tokenLength = strlen(token);
+        for (size_t i = 0; i + tokenLength <= length; ++i) {
+            if (payload[i] == token[0] && memcmp(payload + i, token, tokenLength) == 0) return true;
+        }
+        return false;
+    }
+
+    bool Bot::scanFrameHead(const uint8_t* payload, size_t length, FrameHead& head) {
+        // Walks the frame once, tracking nesting so only keys of the outer object are matched.
+        // Discord sends "t", "s" and "op" ahead of "d", so this usually stops within the first few dozen bytes.
+        bool foundOp = false, foundS = false, foundT = false;
+        int depth = 0;
+        size_t i = 0;
+        while (i < length && !(foundOp && foundS && foundT)) {
+            uint8_t c = payload[i];
+            if (c == '"') {
+                size_t start = ++i;
+                while (i < length && payload[i] != '"') {
+                    i += payload[i] == '\\' ? 2 : 1;
+                }
+                if (i >= length) return false;
+                size_t keyLength = i - start;
+                const char* key = reinterpret_cast<const char*>(payload + start);
+                ++i;
+                if (depth != 1) continue;
+                while (i < length && isspace(payload[i])) ++i;
+                if (i >= length || payload[i] != ':') continue;
+                ++i;
+                while (i < length && isspace(payload[i])) ++i;
+                if (i >= length) return false;
+
+                if (keyLength == 2 && memcmp(key, "op", 2) == 0) {
+                    head.op = atoi(reinterpret_cast<const char*>(payload + i));
+                    foundOp = true;
+                }
+                else if (keyLength == 1 && key[0] == 's') {
+                    head.hasSequence = isdigit(payload[i]);
+                    head.s = head.hasSequence ? strtoul(reinterpret_cast<const char*>(payload + i), nullptr, 10) : 0;
+                    foundS = true;
+                }
+                else if (keyLength == 1 && key[0] == 't') {
+                    if (payload[i] == '"') {
+                        // Type names never contain escapes.
+                        const uint8_t* end = static_cast<const uint8_t*>(memchr(payload + i + 1, '"', length - i - 1));
+                        if (!end) return false;
+                        head.t = reinterpret_cast<const char*>(payload + i + 1);
+                        head.tLength = end - payload - i - 1;
+                    }
+                    foundT = true;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') --depth;
+            ++i;
         }
+        return foundOp;
+    }
+
+    void Bot::recordFrame(FlightRecorder::Direction direction, const uint8_t* wire, size_t wireLength,
+        const uint8_t* json, size_t jsonLength) {
+        if (!_recorder || !_recorder->recording()) return;
+        FrameHead head;
+        uint8_t opcode = json && scanFrameHead(json, jsonLength, head) && head.op >= 0 && head.op < 0xFF ?
+            head.op : FlightRecorder::UNKNOWN_OPCODE;
+        _recorder->record(direction, opcode, wire, wireLength, millis());
+    }
+
+    bool Bot::skipDispatch(EventType type) const {
+        return !subscribed(eventFamily(type));
+    }
+
+    JsonDocument& Bot::guildCreateFilter() {
+        static StaticJsonDocument<384> filter;
+        if (filter.isNull()) {
+            filter[_op] = true;
+            filter["s"] = true;
+            filter[_t] = true;
+            JsonObject d = filter.createNestedObject(_d);
+            d["id"] = true;
+            d["name"] = true;
+            JsonObject channel = d.createNestedArray("channels").createNestedObject();
+            channel["id"] = true;
+            channel["name"] = true;
+            channel["type"] = true;
+            JsonObject role = d.createNestedArray("roles").createNestedObject();
+            role["id"] = true;
+            role["name"] = true;
+            role["permissions"] = true;
+            role["color"] = true;
+            role["position"] = true;
+        }
+        return filter;
+    }
+
+    JsonDocument& Bot::readyFilter() {
+        static StaticJsonDocument<192> filter;
+        if (filter.isNull()) {
+            filter[_op] = true;
+            filter["s"] = true;
+            filter[_t] = true;
+            JsonObject d = filter.createNestedObject(_d);
+            d["session_id"] = true;
+            d["resume_gateway_url"] = true;
+            d["application"]["id"] = true;
+        }
+        return filter;
     }
 
     void Bot::identify() {
-        String payload;
+        // Nothing in Identify changes between sessions, so it is built once per login.
+        if (_identifyPayload.isEmpty()) {
+            prepareIdentify();
+        }
+
+        // A new session numbers its dispatches from 1. Heartbeats sent before READY must not carry the sequence of
+        // the previous session, and neither may a resume of the new one.
+        _lastSocketSequence = 0;
+        _resumePayload.clear();
+
+        if (!sendWS(_identifyPayload.c_str(), _identifyPayload.length())) return;
+
+        Serial.print(DISCORD_LOG_PREFIX "Identify event sent. Intents: ");
+        Serial.println(_intents.value);
+    }
+
+    void Bot::prepareIdentify() {
         StaticJsonDocument<256> doc;
 
         doc[_op] = 2;
 
         JsonObject d = doc.createNestedObject(_d);
         d["token"] = _botToken;
-        d["intents"] = _intents;
+        d["intents"] = _intents.value;
+        if (_shardCount > 0) {
+            JsonArray shard = d.createNestedArray("shard");
+            shard.add(_shardId);
+            shard.add(_shardCount);
+        }
 
         JsonObject d_properties = d.createNestedObject("properties");
         d_properties["os"] = "esp32";
         d_properties["browser"] = "esp32";
         d_properties["device"] = "m5stack";
 
-        serializeJson(doc, payload);
-
-        if (!sendWS(payload.c_str(), payload.length())) return;
-
-        Serial.print(DISCORD_LOG_PREFIX "Identify event sent. Intents: ");
-        Serial.println(_intents);
+        _identifyPayload.reserve(measureJson(doc));
+        serializeJson(doc, _identifyPayload);
     }
 
-    void Bot::heartbeat() {
+    bool Bot::heartbeat() {
         if (!_socket.isConnected()) {
             log_e(DISCORD_LOG_PREFIX "Heartbeat not sent. No active connection.");
-            return;
+            return false;
         }
-        String payload = "{\"op\":1,\"d\":";
+        static const PayloadTemplate<16> heartbeatPayload = PayloadTemplate<16>("{\"op\":1,\"d\":").slot().text("}");
+        char sequence[DISCORD_SNOWFLAKE_DIGITS + 1];
+        const char* d = sequence;
         if (_lastSocketSequence > 0) {
-            payload += _lastSocketSequence;
-            payload += "}";
+            Snowflake(_lastSocketSequence).format(sequence);
         }
         else {
-            payload += "null}";
+            d = "null";
         }
 
-        if (!sendWS(payload.c_str(), payload.length())) return;
-        // Send a periodic request to Discord to preserve the TCP connection.
-        _httpsMtx.lock();
-        sendRest("GET", DISCORD_API_URI "/gateway");
-        _httpsMtx.unlock();
-
-        _lastHeartbeatSend = _now;
+        char payload[40];
+        size_t length = heartbeatPayload.render(payload, sizeof(payload), &d, 1);
+        if (!sendWS(payload, length)) return false;
+        _heartbeatSentAt = millis();
+        // Heartbeats requested by Discord restart the interval as well.
+        if (_heartbeatInterval > 0) {
+            _timers.schedule(_heartbeatTimer, _now, _heartbeatInterval);
+            _timers.schedule(_heartbeatAckTimer, _now, heartbeatAckTimeout());
+        }
+        // Send a periodic request to Discord to preserve the TCP connection. It is queued as bulk work so the Gateway
+        // loop never waits for the REST connection, and skipped when queued requests will use the connection anyway.
+        if (_metrics.gauge(Metrics::Gauge::RestQueueDepth) == 0) {
+            sendPostAsync<16>("GET", DISCORD_API_URI "/gateway", "", "", nullptr, &_restScheduler);
+        }
 
         if (_lastSocketSequence > 0) {
             Serial.print(DISCORD_LOG_PREFIX "Heartbeat sent. Sequence: ");
@@ -502,6 +1465,7 @@ namespace Discord {
         else {
             Serial.println(F(DISCORD_LOG_PREFIX "Heartbeat sent."));
         }
+        return true;
     }
 
     void Bot::resume() {
@@ -512,7 +1476,30 @@ namespace Discord {
             Serial.println(DISCORD_LOG_PREFIX "No session id found! Unable to resume.");
 #endif
         }
-        String payload;
+        // Built once per session, only the sequence number changes between resumes.
+        if (_resumePayload.length() == 0) {
+            prepareResume();
+        }
+        if (_resumePayload.length() == 0 || _resumePayload.overflowed()) {
+#ifdef ESP32
+            log_e(DISCORD_LOG_PREFIX "Resume payload does not fit in DISCORD_RESUME_PAYLOAD_SIZE!");
+#else
+            Serial.println(DISCORD_LOG_PREFIX "Resume payload does not fit in DISCORD_RESUME_PAYLOAD_SIZE!");
+#endif
+            return;
+        }
+        char sequence[DISCORD_SNOWFLAKE_DIGITS + 1];
+        Snowflake(_lastSocketSequence).format(sequence);
+        const char* seq = sequence;
+
+        char payload[DISCORD_RESUME_PAYLOAD_SIZE + DISCORD_SNOWFLAKE_DIGITS];
+        size_t length = _resumePayload.render(payload, sizeof(payload), &seq, 1);
+        if (length >= sizeof(payload) || !sendWS(payload, length)) return;
+
+        Serial.println(DISCORD_LOG_PREFIX "Resume event sent.");
+    }
+
+    void Bot::prepareResume() {
         StaticJsonDocument<256> doc;
 
         doc[_op] = 6;
@@ -520,13 +1507,14 @@ namespace Discord {
         JsonObject d = doc.createNestedObject(_d);
         d["token"] = _botToken;
         d["session_id"] = _sessionId;
-        d["seq"] = _lastSocketSequence;
-
-        serializeJson(doc, payload);
-
-        if (!sendWS(payload.c_str(), payload.length())) return;
 
-        Serial.println(DISCORD_LOG_PREFIX "Resume event sent.");
+        // Serialize without the sequence number, then reopen the object to leave a slot for it.
+        char fixed[DISCORD_RESUME_PAYLOAD_SIZE];
+        size_t length = serializeJson(doc, fixed, sizeof(fixed));
+        _resumePayload.clear();
+        // A full buffer means the output was cut short.
+        if (length < 2 || length >= sizeof(fixed) - 1) return;
+        _resumePayload.text(fixed, length - 2).text(",\"seq\":").slot().text("}}");
     }
 
     inline bool Bot::sendWS(const char* payload, size_t length) {
@@ -536,16 +1524,39 @@ namespace Discord {
 #else
             Serial.println(DISCORD_LOG_PREFIX "Rate limit reached! Maximum of 120 WebSocket events/min.");
 #endif
+            _metrics.increment(Metrics::Counter::GatewaySendsDropped);
+            return false;
+        }
+#ifdef DISCORD_GATEWAY_ETF
+        // Payloads are built as JSON throughout, re-encode them for the wire.
+        PlacedJsonDocument doc(length * 2 + 256, PlacedAllocator(BufferKind::LargeFrame));
+        if (deserializeJson(doc, payload, length)) {
+            _metrics.increment(Metrics::Counter::GatewaySendsDropped);
             return false;
         }
+        static uint8_t buffer[DISCORD_ETF_SEND_BUFFER];
+        size_t encoded = serializeEtf(doc.as<JsonVariantConst>(), buffer, sizeof(buffer));
+        if (encoded > 0 && _socket.sendBIN(buffer, encoded)) {
+            ++_eventsSent;
+            recordFrame(FlightRecorder::Direction::Sent, buffer, encoded,
+                reinterpret_cast<const uint8_t*>(payload), length);
+            return true;
+        }
+#else
         if (_socket.sendTXT(payload, length)) {
             ++_eventsSent;
+            recordFrame(FlightRecorder::Direction::Sent, reinterpret_cast<const uint8_t*>(payload), length,
+                reinterpret_cast<const uint8_t*>(payload), length);
             return true;
         }
+#endif
+        _metrics.increment(Metrics::Counter::GatewaySendsDropped);
         return false;
     }
 
-    bool Bot::sendRest(const char* method, const String & uri, const String & json, const char* authorisationToken) {
+    bool Bot::sendRest(const char* method, const char* uri, const String & json, const char* authorisationToken) {
+        RestTurn turn(_restScheduler, RestScheduler::deadline(RestPriority::Bulk, millis()), RestPriority::Bulk);
+        if (turn.missedDeadline()) _metrics.increment(Metrics::Counter::RestDeadlinesMissed);
         _https.setURL(uri);
 
         if (strcmp(method, "GET") != 0) {
@@ -557,6 +1568,9 @@ namespace Discord {
             }
         }
 
+        // Opened separately so the round trip below does not include a handshake.
+        _rest->connect(&_metrics);
+        unsigned long start = millis();
         int httpResponseCode = 0;
         if (!json.isEmpty()) {
             httpResponseCode = _https.sendRequest(method, json);
@@ -565,9 +1579,10 @@ namespace Discord {
         else {
             httpResponseCode = _https.sendRequest(method);
         }
+        _metrics.restRoundTrip(Metrics::classify(uri)).record(millis() - start);
 #ifdef _DISCORD_CLIENT_DEBUG
 #ifdef ESP32
-        log_d("[DISCORD] Sent %s request to %s", method, uri.c_str());
+        log_d("[DISCORD] Sent %s request to %s", method, uri);
 #else
         Serial.print(method);
         Serial.print(" request to ");
@@ -590,6 +1605,7 @@ namespace Discord {
 #else
                 Serial.println("[DISCORD] 401 Not Authorised.");
 #endif
+                _metrics.increment(Metrics::Counter::RestRequestsFailed);
                 return false;
             }
             if (httpResponseCode != HTTP_CODE_NO_CONTENT) { //204 no content
@@ -605,6 +1621,7 @@ namespace Discord {
         }
 
         // Request failed
+        _metrics.increment(Metrics::Counter::RestRequestsFailed);
         Serial.print("[DISCORD] Error code: ");
         Serial.println(httpResponseCode);
         return false;
@@ -0,0 +1,132 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Ed25519.h>
+
+#include <discord.h>
+#include <endpoint.h>
+
+#define DISCORD_LOG_PREFIX "[DISCORD] "
+
+namespace Discord {
+    InteractionsEndpoint::InteractionsEndpoint(Bot& bot, uint16_t port, const char* path) :
+        _bot { bot }, _server { port }, _path { path } {}
+
+    bool InteractionsEndpoint::begin(const char* publicKey) {
+        if (!publicKey || strlen(publicKey) != 64 || !decodeHex(publicKey, 64, _publicKey)) {
+#ifdef ESP32
+            log_e(DISCORD_LOG_PREFIX "Endpoint public key must be 64 hex digits.");
+#else
+            Serial.println(DISCORD_LOG_PREFIX "Endpoint public key must be 64 hex digits.");
+#endif
+            return false;
+        }
+
+        static const char* signatureHeaders[] = { "X-Signature-Ed25519", "X-Signature-Timestamp" };
+        _server.collectHeaders(signatureHeaders, 2);
+        _server.on(_path, HTTP_POST, [this]() { this->handleRequest(); });
+        _server.begin();
+        _started = true;
+        Serial.print(DISCORD_LOG_PREFIX "Interactions endpoint listening on ");
+        Serial.println(_path);
+        return true;
+    }
+
+    void InteractionsEndpoint::stop() {
+        if (!_started) return;
+        _server.stop();
+        _started = false;
+    }
+
+    void InteractionsEndpoint::update() {
+        if (_started) {
+            _server.handleClient();
+        }
+    }
+
+    void InteractionsEndpoint::handleRequest() {
+        unsigned long receivedAt = millis();
+        const String& body = _server.arg("plain");
+
+        if (!verify(_server.header("X-Signature-Ed25519"), _server.header("X-Signature-Timestamp"), body)) {
+            // Discord probes the endpoint with bad signatures and expects them refused.
+            _bot._metrics.increment(Metrics::Counter::EndpointRequestsRejected);
+            _server.send(401, "text/plain", "invalid request signature");
+            return;
+        }
+
+        // The body is already in the message buffer after the timestamp, parse it there without copying.
+        size_t offset = _server.header("X-Signature-Timestamp").length();
+        DynamicJsonDocument doc(2048);
+        unsigned long parseStart = micros();
+        DeserializationError e = deserializeJson(doc, reinterpret_cast<char*>(_message + offset), body.length());
+        _bot._metrics.parseTime(Metrics::Frame::Interaction).record(micros() - parseStart);
+        if (e) {
+            Serial.print(DISCORD_LOG_PREFIX "Endpoint payload deserialization failed with code ");
+            Serial.println(e.c_str());
+            _bot._metrics.increment(Metrics::Counter::FramesDiscarded);
+            _server.send(400, "text/plain", "malformed interaction");
+            return;
+        }
+
+        // PING, sent when the endpoint URL is saved in the developer portal
+        if (doc["type"] == 1) {
+            _server.send(200, "application/json", "{\"type\":1}");
+            return;
+        }
+
+        String response((char*)0);
+        if (!_bot.answerEndpointInteraction(doc.as<JsonObject>(), receivedAt, response)) {
+            // Nothing answered it. Like on the Gateway, Discord then reports the interaction as failed.
+            _server.send(500, "text/plain", "no response");
+            return;
+        }
+        _server.send(200, "application/json", response);
+    }
+
+    bool InteractionsEndpoint::verify(const String& signature, const String& timestamp, const String& body) {
+        // Refuse anything malformed before paying for the signature check, which takes tens of ms.
+        if (signature.length() != 128 || timestamp.isEmpty() || timestamp.length() > 32) return false;
+        if (body.isEmpty() || body.length() > DISCORD_ENDPOINT_MAX_BODY) return false;
+
+        uint8_t signatureBytes[64];
+        if (!decodeHex(signature.c_str(), 128, signatureBytes)) return false;
+
+        memcpy(_message, timestamp.c_str(), timestamp.length());
+        memcpy(_message + timestamp.length(), body.c_str(), body.length());
+        return Ed25519::verify(signatureBytes, _publicKey, _message, timestamp.length() + body.length());
+    }
+
+    bool InteractionsEndpoint::decodeHex(const char* hex, size_t length, uint8_t* out) {
+        for (size_t i = 0; i < length; ++i) {
+            char c = hex[i];
+            uint8_t nibble;
+            if (c >= '0' && c <= '9') nibble = c - '0';
+            else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+            else return false;
+            if (i % 2 == 0) {
+                out[i / 2] = nibble << 4;
+            }
+            else {
+                out[i / 2] |= nibble;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,374 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <etf.h>
+#include <snowflake.h>
+
+namespace Discord {
+    namespace {
+        enum EtfTag : uint8_t {
+            VERSION = 131,
+            NEW_FLOAT_EXT = 70,
+            SMALL_INTEGER_EXT = 97,
+            INTEGER_EXT = 98,
+            FLOAT_EXT = 99,
+            ATOM_EXT = 100,
+            SMALL_TUPLE_EXT = 104,
+            LARGE_TUPLE_EXT = 105,
+            NIL_EXT = 106,
+            STRING_EXT = 107,
+            LIST_EXT = 108,
+            BINARY_EXT = 109,
+            SMALL_BIG_EXT = 110,
+            LARGE_BIG_EXT = 111,
+            SMALL_ATOM_EXT = 115,
+            MAP_EXT = 116,
+            ATOM_UTF8_EXT = 118,
+            SMALL_ATOM_UTF8_EXT = 119
+        };
+
+        class EtfDecoder {
+        public:
+            EtfDecoder(uint8_t* data, size_t length) : _data { data }, _length { length } {}
+
+            // A null filter keeps everything. Otherwise it follows DeserializationOption::Filter: true keeps a value,
+            // objects select members and the first element of an array filters every element.
+            // Terms that are filtered out are still walked, into an unbound variant, to find where they end.
+            DeserializationError::Code decode(JsonVariant out, uint8_t depth, JsonVariantConst filter) {
+                if (depth > DISCORD_ETF_NESTING_LIMIT) return DeserializationError::TooDeep;
+                if (filter.is<bool>()) {
+                    return decode(filter.as<bool>() ? out : JsonVariant(), depth, JsonVariantConst());
+                }
+                if (!available(1)) return DeserializationError::IncompleteInput;
+
+                size_t start = _position;
+                uint8_t tag = _data[_position++];
+                switch (tag) {
+                    case SMALL_INTEGER_EXT:
+                        if (!available(1)) return DeserializationError::IncompleteInput;
+                        out.set(_data[_position++]);
+                        return DeserializationError::Ok;
+                    case INTEGER_EXT:
+                        if (!available(4)) return DeserializationError::IncompleteInput;
+                        out.set(static_cast<int32_t>(readUnsigned(4)));
+                        return DeserializationError::Ok;
+                    case NEW_FLOAT_EXT: {
+                        if (!available(8)) return DeserializationError::IncompleteInput;
+                        uint64_t bits = readUnsigned(8);
+                        double value;
+                        memcpy(&value, &bits, sizeof(value));
+                        out.set(value);
+                        return DeserializationError::Ok;
+                    }
+                    case FLOAT_EXT: {
+                        // Legacy: the float printed as a 31 byte, null padded string.
+                        if (!available(31)) return DeserializationError::IncompleteInput;
+                        char text[32];
+                        memcpy(text, _data + _position, 31);
+                        text[31] = '\0';
+                        _position += 31;
+                        out.set(atof(text));
+                        return DeserializationError::Ok;
+                    }
+                    case ATOM_EXT:
+                    case ATOM_UTF8_EXT:
+                    case SMALL_ATOM_EXT:
+                    case SMALL_ATOM_UTF8_EXT: {
+                        size_t headerSize = (tag == SMALL_ATOM_EXT || tag == SMALL_ATOM_UTF8_EXT) ? 1 : 2;
+                        const char* atom = readString(start, headerSize);
+                        if (!atom) return DeserializationError::IncompleteInput;
+                        if (strcmp(atom, "nil") == 0 || strcmp(atom, "null") == 0) {
+                            out.clear();
+                        }
+                        else if (strcmp(atom, "true") == 0) {
+                            out.set(true);
+                        }
+                        else if (strcmp(atom, "false") == 0) {
+                            out.set(false);
+                        }
+                        else {
+                            out.set(atom);
+                        }
+                        return DeserializationError::Ok;
+                    }
+                    case STRING_EXT: {
+                        const char* str = readString(start, 2);
+                        if (!str) return DeserializationError::IncompleteInput;
+                        out.set(str);
+                        return DeserializationError::Ok;
+                    }
+                    case BINARY_EXT: {
+                        const char* str = readString(start, 4);
+                        if (!str) return DeserializationError::IncompleteInput;
+                        out.set(str);
+                        return DeserializationError::Ok;
+                    }
+                    case SMALL_BIG_EXT:
+                    case LARGE_BIG_EXT:
+                        return decodeBig(out, tag == SMALL_BIG_EXT ? 1 : 4);
+                    case NIL_EXT:
+                        // The empty list
+                        out.to<JsonArray>();
+                        return DeserializationError::Ok;
+                    case SMALL_TUPLE_EXT:
+                    case LARGE_TUPLE_EXT:
+                    case LIST_EXT: {
+                        size_t countSize = tag == SMALL_TUPLE_EXT ? 1 : 4;
+                        if (!available(countSize)) return DeserializationError::IncompleteInput;
+                        uint32_t count = readUnsigned(countSize);
+                        JsonArray array = out.to<JsonArray>();
+                        JsonVariantConst elementFilter = filter.is<JsonArrayConst>() ? filter[0] : filter;
+                        bool keep = filter.isNull() || !elementFilter.isNull();
+                        for (uint32_t i = 0; i < count; ++i) {
+                            DeserializationError::Code e = decode(keep ? array.add() : JsonVariant(), depth + 1,
+                                elementFilter);
+                            if (e != DeserializationError::Ok) return e;
+                        }
+                        if (tag == LIST_EXT) {
+                            // Proper lists end in NIL_EXT, anything else is an improper tail kept as a last element.
+                            if (!available(1)) return DeserializationError::IncompleteInput;
+                            if (_data[_position] == NIL_EXT) {
+                                ++_position;
+                            }
+                            else {
+                                DeserializationError::Code e = decode(keep ? array.add() : JsonVariant(), depth + 1,
+                                    elementFilter);
+                                if (e != DeserializationError::Ok) return e;
+                            }
+                        }
+                        return DeserializationError::Ok;
+                    }
+                    case MAP_EXT: {
+                        if (!available(4)) return DeserializationError::IncompleteInput;
+                        uint32_t count = readUnsigned(4);
+                        JsonObject object = out.to<JsonObject>();
+                        for (uint32_t i = 0; i < count; ++i) {
+                            char number[DISCORD_SNOWFLAKE_DIGITS + 2];
+                            const char* key = readKey(number);
+                            if (!key) return DeserializationError::InvalidInput;
+                            JsonVariantConst memberFilter = filter.isNull() ? filter : filter[key];
+                            bool keep = !object.isNull() && (filter.isNull() || !memberFilter.isNull());
+                            // Numeric keys live on the stack and must be copied, text keys can be linked.
+                            JsonVariant value = !keep ? JsonVariant() : key == number ?
+                                object[const_cast<char*>(key)].to<JsonVariant>() : object[key].to<JsonVariant>();
+                            DeserializationError::Code e = decode(value, depth + 1, memberFilter);
+                            if (e != DeserializationError::Ok) return e;
+                        }
+                        return DeserializationError::Ok;
+                    }
+                    default:
+                        return DeserializationError::InvalidInput;
+                }
+            }
+
+            bool atEnd() const { return _position == _length; }
+        private:
+            bool available(size_t count) const { return _length - _position >= count; }
+
+            uint64_t readUnsigned(size_t bytes) {
+                // ETF is big-endian.
+                uint64_t value = 0;
+                for (size_t i = 0; i < bytes; ++i) {
+                    value = (value << 8) | _data[_position++];
+                }
+                return value;
+            }
+
+            // Strings are moved back over their own length header and terminated in the space that frees up,
+            // which never reaches the next term.
+            const char* readString(size_t tagPosition, size_t headerSize) {
+                if (!available(headerSize)) return nullptr;
+                size_t length = readUnsigned(headerSize);
+                if (!available(length)) return nullptr;
+                char* destination = reinterpret_cast<char*>(_data + tagPosition);
+                memmove(destination, _data + _position, length);
+                destination[length] = '\0';
+                _position += length;
+                return destination;
+            }
+
+            DeserializationError::Code decodeBig(JsonVariant out, size_t countSize) {
+                if (!available(countSize + 1)) return DeserializationError::IncompleteInput;
+                size_t digits = readUnsigned(countSize);
+                bool negative = _data[_position++] != 0;
+                if (!available(digits)) return DeserializationError::IncompleteInput;
+                if (digits > 8) return DeserializationError::InvalidInput;
+                // Little-endian magnitude.
+                uint64_t magnitude = 0;
+                for (size_t i = 0; i < digits; ++i) {
+                    magnitude |= static_cast<uint64_t>(_data[_position++]) << (8 * i);
+                }
+                // 64-bit values are snowflakes and bit sets, which the JSON encoding sends as strings.
+                char text[DISCORD_SNOWFLAKE_DIGITS + 2];
+                size_t offset = 0;
+                if (negative) text[offset++] = '-';
+                Snowflake(magnitude).format(text + offset);
+                out.set(static_cast<char*>(text));
+                return DeserializationError::Ok;
+            }
+
+            const char* readKey(char* number) {
+                if (!available(1)) return nullptr;
+                size_t start = _position;
+                uint8_t tag = _data[_position++];
+                switch (tag) {
+                    case ATOM_EXT:
+                    case ATOM_UTF8_EXT:
+                        return readString(start, 2);
+                    case SMALL_ATOM_EXT:
+                    case SMALL_ATOM_UTF8_EXT:
+                        return readString(start, 1);
+                    case STRING_EXT:
+                        return readString(start, 2);
+                    case BINARY_EXT:
+                        return readString(start, 4);
+                    case SMALL_INTEGER_EXT:
+                        if (!available(1)) return nullptr;
+                        Snowflake(_data[_position++]).format(number);
+                        return number;
+                    case INTEGER_EXT: {
+                        if (!available(4)) return nullptr;
+                        int32_t value = static_cast<int32_t>(readUnsigned(4));
+                        snprintf(number, DISCORD_SNOWFLAKE_DIGITS + 2, "%ld", static_cast<long>(value));
+                        return number;
+                    }
+                    default:
+                        return nullptr;
+                }
+            }
+
+            uint8_t* _data;
+            size_t _length;
+            size_t _position = 1;
+        };
+
+        class EtfEncoder {
+        public:
+            EtfEncoder(uint8_t* buffer, size_t size) : _buffer { buffer }, _size { size } {}
+
+            bool encode(JsonVariantConst value) {
+                if (value.isNull()) {
+                    return writeAtom("nil");
+                }
+                if (value.is<bool>()) {
+                    return writeAtom(value.as<bool>() ? "true" : "false");
+                }
+                if (value.is<JsonObjectConst>()) {
+                    JsonObjectConst object = value.as<JsonObjectConst>();
+                    if (!writeByte(MAP_EXT) || !writeUnsigned(object.size(), 4)) return false;
+                    for (JsonPairConst pair : object) {
+                        if (!writeBinary(pair.key().c_str(), pair.key().size()) || !encode(pair.value())) return false;
+                    }
+                    return true;
+                }
+                if (value.is<JsonArrayConst>()) {
+                    JsonArrayConst array = value.as<JsonArrayConst>();
+                    if (array.size() == 0) return writeByte(NIL_EXT);
+                    if (!writeByte(LIST_EXT) || !writeUnsigned(array.size(), 4)) return false;
+                    for (JsonVariantConst element : array) {
+                        if (!encode(element)) return false;
+                    }
+                    return writeByte(NIL_EXT);
+                }
+                if (value.is<const char*>()) {
+                    const char* str = value.as<const char*>();
+                    return writeBinary(str, strlen(str));
+                }
+                if (value.is<uint8_t>()) {
+                    return writeByte(SMALL_INTEGER_EXT) && writeByte(value.as<uint8_t>());
+                }
+                if (value.is<int32_t>()) {
+                    return writeByte(INTEGER_EXT) && writeUnsigned(static_cast<uint32_t>(value.as<int32_t>()), 4);
+                }
+                if (value.is<int64_t>() || value.is<uint64_t>()) {
+                    bool negative = value.is<int64_t>() && value.as<int64_t>() < 0;
+                    uint64_t magnitude = negative ?
+                        static_cast<uint64_t>(-(value.as<int64_t>() + 1)) + 1 : value.as<uint64_t>();
+                    uint8_t digits = 0;
+                    for (uint64_t m = magnitude; m > 0; m >>= 8) ++digits;
+                    if (!writeByte(SMALL_BIG_EXT) || !writeByte(digits) || !writeByte(negative ? 1 : 0)) return false;
+                    for (uint8_t i = 0; i < digits; ++i) {
+                        if (!writeByte((magnitude >> (8 * i)) & 0xFF)) return false;
+                    }
+                    return true;
+                }
+                double number = value.as<double>();
+                uint64_t bits;
+                memcpy(&bits, &number, sizeof(bits));
+                return writeByte(NEW_FLOAT_EXT) && writeUnsigned(bits, 8);
+            }
+
+            bool writeByte(uint8_t byte) {
+                if (_position >= _size) return false;
+                _buffer[_position++] = byte;
+                return true;
+            }
+
+            size_t position() const { return _position; }
+        private:
+            bool writeUnsigned(uint64_t value, size_t bytes) {
+                if (_size - _position < bytes) return false;
+                for (size_t i = 0; i < bytes; ++i) {
+                    _buffer[_position++] = (value >> (8 * (bytes - 1 - i))) & 0xFF;
+                }
+                return true;
+            }
+
+            bool writeBinary(const char* str, size_t length) {
+                if (!writeByte(BINARY_EXT) || !writeUnsigned(length, 4) || _size - _position < length) return false;
+                memcpy(_buffer + _position, str, length);
+                _position += length;
+                return true;
+            }
+
+            bool writeAtom(const char* atom) {
+                size_t length = strlen(atom);
+                if (!writeByte(SMALL_ATOM_UTF8_EXT) || !writeByte(length) || _size - _position < length) return false;
+                memcpy(_buffer + _position, atom, length);
+                _position += length;
+                return true;
+            }
+
+            uint8_t* _buffer;
+            size_t _size;
+            size_t _position = 0;
+        };
+    }
+
+    DeserializationError deserializeEtf(JsonDocument& doc, uint8_t* data, size_t length) {
+        return deserializeEtf(doc, data, length, JsonVariantConst());
+    }
+
+    DeserializationError deserializeEtf(JsonDocument& doc, uint8_t* data, size_t length, JsonVariantConst filter) {
+        doc.clear();
+        if (length == 0) return DeserializationError::EmptyInput;
+        if (data[0] != VERSION) return DeserializationError::InvalidInput;
+
+        EtfDecoder decoder(data, length);
+        DeserializationError::Code e = decoder.decode(doc.to<JsonVariant>(), 0, filter);
+        if (e != DeserializationError::Ok) return e;
+        if (doc.overflowed()) return DeserializationError::NoMemory;
+        return decoder.atEnd() ? DeserializationError::Ok : DeserializationError::InvalidInput;
+    }
+
+    size_t serializeEtf(JsonVariantConst source, uint8_t* buffer, size_t size) {
+        EtfEncoder encoder(buffer, size);
+        if (!encoder.writeByte(VERSION) || !encoder.encode(source)) return 0;
+        return encoder.position();
+    }
+}
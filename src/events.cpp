@@ -0,0 +1,175 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <events.h>
+
+namespace Discord {
+    namespace {
+        struct DispatchName {
+            const char* name;
+            EventType type;
+        };
+
+        const DispatchName dispatchNames[] = {
+            { "READY", EventType::Ready },
+            { "RESUMED", EventType::Resumed },
+            { "APPLICATION_COMMAND_PERMISSIONS_UPDATE", EventType::ApplicationCommandPermissionsUpdate },
+            { "AUTO_MODERATION_RULE_CREATE", EventType::AutoModerationRuleCreate },
+            { "AUTO_MODERATION_RULE_UPDATE", EventType::AutoModerationRuleUpdate },
+            { "AUTO_MODERATION_RULE_DELETE", EventType::AutoModerationRuleDelete },
+            { "AUTO_MODERATION_ACTION_EXECUTION", EventType::AutoModerationRuleExecution },
+            { "CHANNEL_CREATE", EventType::ChannelCreate },
+            { "CHANNEL_UPDATE", EventType::ChannelUpdate },
+            { "CHANNEL_DELETE", EventType::ChannelDelete },
+            { "THREAD_CREATE", EventType::ThreadCreate },
+            { "THREAD_UPDATE", EventType::ThreadUpdate },
+            { "THREAD_DELETE", EventType::ThreadDelete },
+            { "THREAD_LIST_SYNC", EventType::ThreadListSync },
+            { "THREAD_MEMBER_UPDATE", EventType::ThreadMemberUpdate },
+            { "THREAD_MEMBERS_UPDATE", EventType::ThreadMembersUpdate },
+            { "CHANNEL_PINS_UPDATE", EventType::ChannelPinsUpdate },
+            { "GUILD_CREATE", EventType::GuildCreate },
+            { "GUILD_UPDATE", EventType::GuildUpdate },
+            { "GUILD_DELETE", EventType::GuildDelete },
+            { "GUILD_AUDIT_LOG_ENTRY_CREATE", EventType::GuildAuditLogEntryCreate },
+            { "GUILD_BAN_ADD", EventType::GuildBanAdd },
+            { "GUILD_BAN_REMOVE", EventType::GuildBanRemove },
+            { "GUILD_EMOJIS_UPDATE", EventType::GuildEmojisUpdate },
+            { "GUILD_STICKERS_UPDATE", EventType::GuildStickersUpdate },
+            { "GUILD_INTEGRATIONS_UPDATE", EventType::GuildIntegrationsUpdate },
+            { "GUILD_MEMBER_ADD", EventType::GuildMemberAdd },
+            { "GUILD_MEMBER_REMOVE", EventType::GuildMemberRemove },
+            { "GUILD_MEMBER_UPDATE", EventType::GuildMemberUpdate },
+            { "GUILD_MEMBERS_CHUNK", EventType::GuildMembersChunk },
+            { "GUILD_ROLE_CREATE", EventType::GuildRoleCreate },
+            { "GUILD_ROLE_UPDATE", EventType::GuildRoleUpdate },
+            { "GUILD_ROLE_DELETE", EventType::GuildRoleDelete },
+            { "GUILD_SCHEDULED_EVENT_CREATE", EventType::GuildScheduledEventCreate },
+            { "GUILD_SCHEDULED_EVENT_UPDATE", EventType::GuildScheduledEventUpdate },
+            { "GUILD_SCHEDULED_EVENT_DELETE", EventType::GuildScheduledEventDelete },
+            { "GUILD_SCHEDULED_EVENT_USER_ADD", EventType::GuildScheduledEventUserAdd },
+            { "GUILD_SCHEDULED_EVENT_USER_REMOVE", EventType::GuildScheduledEventUserRemove },
+            { "INTEGRATION_CREATE", EventType::IntegrationCreate },
+            { "INTEGRATION_UPDATE", EventType::IntegrationUpdate },
+            { "INTEGRATION_DELETE", EventType::IntegrationDelete },
+            { "INTERACTION_CREATE", EventType::InteractionCreate },
+            { "INVITE_CREATE", EventType::InviteCreate },
+            { "INVITE_DELETE", EventType::InviteDelete },
+            { "MESSAGE_CREATE", EventType::MessageCreate },
+            { "MESSAGE_UPDATE", EventType::MessageUpdate },
+            { "MESSAGE_DELETE", EventType::MessageDelete },
+            { "MESSAGE_DELETE_BULK", EventType::MessageDeleteBulk },
+            { "MESSAGE_REACTION_ADD", EventType::MessageReactionAdd },
+            { "MESSAGE_REACTION_REMOVE", EventType::MessageReactionRemove },
+            { "MESSAGE_REACTION_REMOVE_ALL", EventType::MessageReactionRemoveAll },
+            { "MESSAGE_REACTION_REMOVE_EMOJI", EventType::MessageReactionRemoveEmoji },
+            { "PRESENCE_UPDATE", EventType::PresenceUpdate },
+            { "STAGE_INSTANCE_CREATE", EventType::StageInstanceCreate },
+            { "STAGE_INSTANCE_UPDATE", EventType::StageInstanceUpdate },
+            { "STAGE_INSTANCE_DELETE", EventType::StageInstanceDelete },
+            { "TYPING_START", EventType::TypingStart },
+            { "USER_UPDATE", EventType::UserUpdate },
+            { "VOICE_STATE_UPDATE", EventType::VoiceStateUpdate },
+            { "VOICE_SERVER_UPDATE", EventType::VoiceServerUpdate },
+            { "WEBHOOKS_UPDATE", EventType::WebhooksUpdate }
+        };
+    }
+
+    EventFamily eventFamily(EventType type) {
+        switch (type) {
+            case EventType::InteractionCreate:
+            case EventType::ApplicationCommandPermissionsUpdate:
+                return EventFamily::Interactions;
+            case EventType::MessageCreate:
+            case EventType::MessageUpdate:
+            case EventType::MessageDelete:
+            case EventType::MessageDeleteBulk:
+                return EventFamily::Messages;
+            case EventType::MessageReactionAdd:
+            case EventType::MessageReactionRemove:
+            case EventType::MessageReactionRemoveAll:
+            case EventType::MessageReactionRemoveEmoji:
+                return EventFamily::Reactions;
+            case EventType::GuildCreate:
+            case EventType::GuildUpdate:
+            case EventType::GuildDelete:
+            case EventType::GuildRoleCreate:
+            case EventType::GuildRoleUpdate:
+            case EventType::GuildRoleDelete:
+            case EventType::GuildEmojisUpdate:
+            case EventType::GuildStickersUpdate:
+                return EventFamily::Guilds;
+            case EventType::ChannelCreate:
+            case EventType::ChannelUpdate:
+            case EventType::ChannelDelete:
+            case EventType::ChannelPinsUpdate:
+            case EventType::ThreadCreate:
+            case EventType::ThreadUpdate:
+            case EventType::ThreadDelete:
+            case EventType::ThreadListSync:
+            case EventType::ThreadMemberUpdate:
+            case EventType::ThreadMembersUpdate:
+                return EventFamily::Channels;
+            case EventType::GuildMemberAdd:
+            case EventType::GuildMemberRemove:
+            case EventType::GuildMemberUpdate:
+            case EventType::GuildMembersChunk:
+                return EventFamily::Members;
+            case EventType::AutoModerationRuleCreate:
+            case EventType::AutoModerationRuleUpdate:
+            case EventType::AutoModerationRuleDelete:
+            case EventType::AutoModerationRuleExecution:
+            case EventType::GuildAuditLogEntryCreate:
+            case EventType::GuildBanAdd:
+            case EventType::GuildBanRemove:
+                return EventFamily::Moderation;
+            case EventType::PresenceUpdate:
+            case EventType::VoiceStateUpdate:
+            case EventType::TypingStart:
+            case EventType::UserUpdate:
+            case EventType::VoiceServerUpdate:
+                return EventFamily::Presence;
+            case EventType::GuildIntegrationsUpdate:
+            case EventType::GuildScheduledEventCreate:
+            case EventType::GuildScheduledEventUpdate:
+            case EventType::GuildScheduledEventDelete:
+            case EventType::GuildScheduledEventUserAdd:
+            case EventType::GuildScheduledEventUserRemove:
+            case EventType::IntegrationCreate:
+            case EventType::IntegrationUpdate:
+            case EventType::IntegrationDelete:
+            case EventType::InviteCreate:
+            case EventType::InviteDelete:
+            case EventType::StageInstanceCreate:
+            case EventType::StageInstanceUpdate:
+            case EventType::StageInstanceDelete:
+            case EventType::WebhooksUpdate:
+                return EventFamily::Other;
+            default:
+                return EventFamily::Lifecycle;
+        }
+    }
+
+    EventType dispatchEventType(const char* name, size_t length) {
+        if (!name) return EventType::Dispatch;
+        for (const DispatchName& entry : dispatchNames) {
+            if (strncmp(entry.name, name, length) == 0 && entry.name[length] == '\0') return entry.type;
+        }
+        return EventType::Dispatch;
+    }
+}
@@ -30,7 +30,7 @@ namespace Discord {
 
         if (!serializeCommand(command, doc)) return 0;
 
-        String url(DISCORD_API_URI "/applications/");
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
         url += bot.applicationId();
         url += "/commands";
 
@@ -38,7 +38,7 @@ namespace Discord {
         json.reserve(1024);
         serializeJson(doc, json);
         StaticJsonDocument<512> response;
-        if (bot.sendRest<512>("POST", url, json, botToken, &response)) {
+        if (bot.sendRest<512>("POST", url.c_str(), json, botToken, &response)) {
             uint64_t idString = response["id"];
 
             Serial.print(DISCORD_INTERACTION_LOG_PREFIX "Global command ");
@@ -49,12 +49,12 @@ namespace Discord {
         return 0;
     }
 
-    uint64_t Interactions::registerGuildCommand(Bot& bot, const char* guildId, const ApplicationCommand& command, const char* botToken) {
+    uint64_t Interactions::registerGuildCommand(Bot& bot, Snowflake guildId, const ApplicationCommand& command, const char* botToken) {
         StaticJsonDocument<1024> doc;
 
         if (!serializeCommand(command, doc)) return 0;
 
-        String url(DISCORD_API_URI "/applications/");
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
         url += bot.applicationId();
         url += "/guilds/";
         url += guildId;
@@ -64,7 +64,7 @@ namespace Discord {
         json.reserve(1024);
         serializeJson(doc, json);
         StaticJsonDocument<512> response;
-        if (bot.sendRest<512>("POST", url, json, botToken, &response)) {
+        if (bot.sendRest<512>("POST", url.c_str(), json, botToken, &response)) {
             uint64_t idString = response["id"];
 
             Serial.print(DISCORD_INTERACTION_LOG_PREFIX " Guild command ");
@@ -75,29 +75,106 @@ namespace Discord {
         return 0;
     }
 
-    bool Interactions::deleteGlobalCommand(Bot& bot, const String& commandId, const char* botToken) {
-        String url(DISCORD_API_URI "/applications/");
+    bool Interactions::deleteGlobalCommand(Bot& bot, Snowflake commandId, const char* botToken) {
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
         url += bot.applicationId();
         url += "/commands/";
         url += commandId;
 
-        bool result = bot.sendRest("DELETE", url, "", botToken);
+        bool result = bot.sendRest("DELETE", url.c_str(), "", botToken);
         return result;
     }
 
     bool Interactions::deleteGuildCommand(
-        Bot& bot, const char* guildId, const String& commandId, const char* botToken) {
-        String url(DISCORD_API_URI "/applications/");
+        Bot& bot, Snowflake guildId, Snowflake commandId, const char* botToken) {
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
         url += bot.applicationId();
         url += "/guilds/";
         url += guildId;
         url += "/commands/";
         url += commandId;
 
-        bool result = bot.sendRest("DELETE", url, "", botToken);
+        bool result = bot.sendRest("DELETE", url.c_str(), "", botToken);
         return result;
     }
 
+    bool Interactions::registerGlobalCommandAsync(
+        Bot& bot, const ApplicationCommand& command, const char* botToken, CommandCallback cb) {
+        StaticJsonDocument<1024> doc;
+        if (!serializeCommand(command, doc)) return false;
+
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
+        url += bot.applicationId();
+        url += "/commands";
+
+        String json((char*)0);
+        json.reserve(1024);
+        serializeJson(doc, json);
+        return sendAsync(bot, "POST", url.c_str(), json, botToken, 0, std::move(cb));
+    }
+
+    bool Interactions::registerGuildCommandAsync(
+        Bot& bot, Snowflake guildId, const ApplicationCommand& command, const char* botToken, CommandCallback cb) {
+        StaticJsonDocument<1024> doc;
+        if (!serializeCommand(command, doc)) return false;
+
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
+        url += bot.applicationId();
+        url += "/guilds/";
+        url += guildId;
+        url += "/commands";
+
+        String json((char*)0);
+        json.reserve(1024);
+        serializeJson(doc, json);
+        return sendAsync(bot, "POST", url.c_str(), json, botToken, 0, std::move(cb));
+    }
+
+    bool Interactions::deleteGlobalCommandAsync(
+        Bot& bot, Snowflake commandId, const char* botToken, CommandCallback cb) {
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
+        url += bot.applicationId();
+        url += "/commands/";
+        url += commandId;
+
+        return sendAsync(bot, "DELETE", url.c_str(), "", botToken, commandId, std::move(cb));
+    }
+
+    bool Interactions::deleteGuildCommandAsync(
+        Bot& bot, Snowflake guildId, Snowflake commandId, const char* botToken, CommandCallback cb) {
+        UrlBuilder<> url(DISCORD_API_URI "/applications/");
+        url += bot.applicationId();
+        url += "/guilds/";
+        url += guildId;
+        url += "/commands/";
+        url += commandId;
+
+        return sendAsync(bot, "DELETE", url.c_str(), "", botToken, commandId, std::move(cb));
+    }
+
+    bool Interactions::sendAsync(Bot& bot, const char* method, const char* uri, const String& json,
+        const char* botToken, uint64_t commandId, CommandCallback cb) {
+        // Registrations answer with the new command, deletions with no content and the id we already know.
+        std::function<void(const StaticJsonDocument<512>&)> done = nullptr;
+        std::function<void(int)> failed = nullptr;
+        if (cb) {
+            done = [cb, commandId](const StaticJsonDocument<512>& response) {
+                uint64_t id = commandId != 0 ? commandId : Snowflake(response["id"].as<const char*>()).value;
+                if (id != 0 && commandId == 0) {
+                    Serial.print(DISCORD_INTERACTION_LOG_PREFIX "Command ");
+                    Serial.print(id);
+                    Serial.println(" registered.");
+                }
+                cb(id != 0, id);
+            };
+            failed = [cb, commandId](int) {
+                cb(false, commandId);
+            };
+        }
+        return bot.sendPostAsync<512>(method, uri, json, botToken, std::move(done), &bot._restScheduler, 0,
+            RestPriority::Bulk, std::move(failed));
+    }
+
     bool Interactions::serializeCommand(const ApplicationCommand& command, StaticJsonDocument<1024>& doc) {
         if (!strlen(command.name) || strlen(command.name) > 32) {
             Serial.println(DISCORD_INTERACTION_LOG_PREFIX "Invalid name provided!");
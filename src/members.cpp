@@ -0,0 +1,137 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <members.h>
+
+namespace Discord {
+    namespace {
+        size_t skipSpace(const uint8_t* p, size_t i, size_t length) {
+            while (i < length && isspace(p[i])) ++i;
+            return i;
+        }
+
+        // Returns the index just past the string starting at p[i] == '"', or length if it is unterminated.
+        size_t skipString(const uint8_t* p, size_t i, size_t length) {
+            ++i;
+            while (i < length && p[i] != '"') {
+                i += p[i] == '\\' ? 2 : 1;
+            }
+            return i < length ? i + 1 : length;
+        }
+
+        // Returns the index just past the value starting at p[i], or length if it is cut short.
+        size_t skipValue(const uint8_t* p, size_t i, size_t length) {
+            if (i >= length) return length;
+            if (p[i] == '"') return skipString(p, i, length);
+            if (p[i] != '{' && p[i] != '[') {
+                while (i < length && p[i] != ',' && p[i] != '}' && p[i] != ']' && !isspace(p[i])) ++i;
+                return i;
+            }
+            int depth = 0;
+            while (i < length) {
+                uint8_t c = p[i];
+                if (c == '"') {
+                    i = skipString(p, i, length);
+                    continue;
+                }
+                if (c == '{' || c == '[') ++depth;
+                else if ((c == '}' || c == ']') && --depth == 0) return i + 1;
+                ++i;
+            }
+            return length;
+        }
+
+        // Calls visit(key, keyLength, valueStart) for each key of the object starting at p[i] == '{'.
+        // Returns false if the object is malformed.
+        template <typename Visitor>
+        bool forEachKey(const uint8_t* p, size_t i, size_t length, Visitor visit) {
+            if (i >= length || p[i] != '{') return false;
+            i = skipSpace(p, i + 1, length);
+            while (i < length && p[i] != '}') {
+                if (p[i] != '"') return false;
+                size_t keyEnd = skipString(p, i, length);
+                const char* key = reinterpret_cast<const char*>(p + i + 1);
+                size_t keyLength = keyEnd - i - 2;
+                i = skipSpace(p, keyEnd, length);
+                if (i >= length || p[i] != ':') return false;
+                i = skipSpace(p, i + 1, length);
+                visit(key, keyLength, i);
+                i = skipSpace(p, skipValue(p, i, length), length);
+                if (i < length && p[i] == ',') i = skipSpace(p, i + 1, length);
+            }
+            return i < length;
+        }
+
+        bool keyIs(const char* key, size_t keyLength, const char* name) {
+            return strlen(name) == keyLength && memcmp(key, name, keyLength) == 0;
+        }
+    }
+
+    bool streamMembersChunk(const uint8_t* payload, size_t length, MembersChunk& chunk,
+        const GuildMemberCallback& callback) {
+        size_t data = length;
+        if (!forEachKey(payload, skipSpace(payload, 0, length), length,
+            [&](const char* key, size_t keyLength, size_t value) {
+                if (keyIs(key, keyLength, "d")) data = value;
+            }) || data >= length) return false;
+
+        // The chunk's details may follow the members, so find them all before streaming any member.
+        size_t members = length;
+        if (!forEachKey(payload, data, length, [&](const char* key, size_t keyLength, size_t value) {
+            const char* text = reinterpret_cast<const char*>(payload + value);
+            if (keyIs(key, keyLength, "members")) {
+                members = value;
+            }
+            else if (keyIs(key, keyLength, "guild_id") && payload[value] == '"') {
+                size_t end = skipString(payload, value, length);
+                Snowflake::parse(text + 1, end - value - 2, chunk.guildId);
+            }
+            else if (keyIs(key, keyLength, "chunk_index")) {
+                chunk.index = strtoul(text, nullptr, 10);
+            }
+            else if (keyIs(key, keyLength, "chunk_count")) {
+                chunk.count = strtoul(text, nullptr, 10);
+            }
+            else if (keyIs(key, keyLength, "nonce") && payload[value] == '"') {
+                size_t nonceLength = skipString(payload, value, length) - value - 2;
+                if (nonceLength > DISCORD_MEMBERS_NONCE_LENGTH) nonceLength = DISCORD_MEMBERS_NONCE_LENGTH;
+                memcpy(chunk.nonce, text + 1, nonceLength);
+                chunk.nonce[nonceLength] = '\0';
+            }
+        }) || members >= length || payload[members] != '[') return false;
+
+        StaticJsonDocument<DISCORD_MEMBER_PARSE_SIZE> doc;
+        size_t i = skipSpace(payload, members + 1, length);
+        while (i < length && payload[i] != ']') {
+            size_t end = skipValue(payload, i, length);
+            if (end >= length) return false;
+            // Parsed as const so strings are copied and the payload stays intact.
+            DeserializationError e = deserializeJson(doc, reinterpret_cast<const char*>(payload + i), end - i);
+            if (e || !doc.is<JsonObject>()) {
+                ++chunk.skipped;
+            }
+            else {
+                ++chunk.members;
+                callback(chunk, doc.as<JsonObjectConst>());
+            }
+            i = skipSpace(payload, end, length);
+            if (i < length && payload[i] == ',') i = skipSpace(payload, i + 1, length);
+        }
+        return i < length;
+    }
+}
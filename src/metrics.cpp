@@ -0,0 +1,247 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <metrics.h>
+
+namespace Discord {
+    namespace {
+        const uint32_t bucketBounds[DISCORD_METRICS_BUCKETS - 1] = {
+            1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000
+        };
+
+        const char* const routeNames[] = {
+            "gateway", "interaction_callback", "application_commands", "channel_messages", "webhooks", "other"
+        };
+
+        const char* const frameNames[] = {
+            "control", "ready", "interaction", "message", "dispatch"
+        };
+
+        const char* const counterNames[] = {
+            "events_dropped", "gateway_sends_dropped", "rest_dropped", "rest_failed", "frames_discarded",
+            "presence_coalesced", "dispatches_skipped", "frames_lazy",
+            "endpoint_rejected", "tls_handshakes", "rest_reused",
+            "interactions_admitted", "interactions_shed", "interactions_dropped",
+            "rest_missed_deadline", "events_missed", "sessions_lost"
+        };
+
+        const char* const gaugeNames[] = {
+            "event_queue", "rest_queue", "pending_interactions"
+        };
+
+        // Line-at-a-time sinks for the text export.
+        struct PrintWriter {
+            Print& out;
+            void operator()(const char* line, size_t length) { out.write(line, length); }
+        };
+
+        struct BufferWriter {
+            char* buffer;
+            size_t size;
+            size_t length;
+            void operator()(const char* line, size_t lineLength) {
+                if (length < size) {
+                    size_t n = size - length - 1 < lineLength ? size - length - 1 : lineLength;
+                    memcpy(buffer + length, line, n);
+                    buffer[length + n] = '\0';
+                }
+                length += lineLength;
+            }
+        };
+
+        template <typename Writer>
+        void writeHistogram(Writer& writer, const char* name, const char* suffix, const Metrics::Histogram::Snapshot& h) {
+            char line[256];
+            int n = snprintf(line, sizeof(line), "h %s%s %u %u %u", name, suffix,
+                static_cast<unsigned>(h.count), static_cast<unsigned>(h.sum), static_cast<unsigned>(h.max));
+            for (size_t i = 0; i < DISCORD_METRICS_BUCKETS && n > 0 && n < static_cast<int>(sizeof(line)); ++i) {
+                n += snprintf(line + n, sizeof(line) - n, " %u", static_cast<unsigned>(h.buckets[i]));
+            }
+            if (n <= 0) return;
+            if (n >= static_cast<int>(sizeof(line)) - 1) n = sizeof(line) - 2;
+            line[n++] = '\n';
+            writer(line, n);
+        }
+    }
+
+    Metrics::Histogram::Histogram() {
+        reset();
+    }
+
+    void Metrics::Histogram::record(uint32_t value) {
+        size_t bucket = 0;
+        while (bucket < DISCORD_METRICS_BUCKETS - 1 && value > bucketBounds[bucket]) {
+            ++bucket;
+        }
+        _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint32_t previous = _max.load(std::memory_order_relaxed);
+        while (value > previous && !_max.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+    }
+
+    void Metrics::Histogram::snapshot(Snapshot& out) const {
+        out.count = _count.load(std::memory_order_relaxed);
+        out.sum = _sum.load(std::memory_order_relaxed);
+        out.max = _max.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < DISCORD_METRICS_BUCKETS; ++i) {
+            out.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void Metrics::Histogram::reset() {
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+        for (size_t i = 0; i < DISCORD_METRICS_BUCKETS; ++i) {
+            _buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    Metrics::Metrics() {
+        for (size_t i = 0; i < static_cast<size_t>(Gauge::COUNT); ++i) {
+            _gauges[i].store(0, std::memory_order_relaxed);
+        }
+        reset();
+    }
+
+    void Metrics::increment(Counter counter, uint32_t amount) {
+        _counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void Metrics::setGauge(Gauge gauge, uint32_t value) {
+        size_t i = static_cast<size_t>(gauge);
+        _gauges[i].store(value, std::memory_order_relaxed);
+        uint32_t previous = _gaugeHighs[i].load(std::memory_order_relaxed);
+        while (value > previous && !_gaugeHighs[i].compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+    }
+
+    void Metrics::adjustGauge(Gauge gauge, int32_t delta) {
+        size_t i = static_cast<size_t>(gauge);
+        uint32_t value = _gauges[i].fetch_add(static_cast<uint32_t>(delta), std::memory_order_relaxed) + delta;
+        uint32_t previous = _gaugeHighs[i].load(std::memory_order_relaxed);
+        while (delta > 0 && value > previous &&
+            !_gaugeHighs[i].compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+    }
+
+    uint32_t Metrics::gauge(Gauge gauge) const {
+        return _gauges[static_cast<size_t>(gauge)].load(std::memory_order_relaxed);
+    }
+
+    void Metrics::snapshot(Snapshot& out) const {
+        _interactionLatency.snapshot(out.interactionLatency);
+        for (size_t i = 0; i < static_cast<size_t>(Route::COUNT); ++i) {
+            _restRoundTrip[i].snapshot(out.restRoundTrip[i]);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Frame::COUNT); ++i) {
+            _parseTime[i].snapshot(out.parseTime[i]);
+        }
+        _heartbeatRoundTrip.snapshot(out.heartbeatRoundTrip);
+        _tlsHandshake.snapshot(out.tlsHandshake);
+        _recoveryTime.snapshot(out.recoveryTime);
+        for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+            out.counters[i] = _counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Gauge::COUNT); ++i) {
+            out.gauges[i] = _gauges[i].load(std::memory_order_relaxed);
+            out.gaugeHighs[i] = _gaugeHighs[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void Metrics::reset() {
+        _interactionLatency.reset();
+        for (size_t i = 0; i < static_cast<size_t>(Route::COUNT); ++i) {
+            _restRoundTrip[i].reset();
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Frame::COUNT); ++i) {
+            _parseTime[i].reset();
+        }
+        _heartbeatRoundTrip.reset();
+        _tlsHandshake.reset();
+        _recoveryTime.reset();
+        for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+            _counters[i].store(0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Gauge::COUNT); ++i) {
+            _gaugeHighs[i].store(_gauges[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    template <typename Writer>
+    void Metrics::writeText(Writer& writer) const {
+        // Snapshot one histogram at a time to keep the stack footprint small.
+        Histogram::Snapshot h;
+        _interactionLatency.snapshot(h);
+        writeHistogram(writer, "interaction_ms", "", h);
+        for (size_t i = 0; i < static_cast<size_t>(Route::COUNT); ++i) {
+            _restRoundTrip[i].snapshot(h);
+            char name[48];
+            snprintf(name, sizeof(name), "rest_ms.%s", routeNames[i]);
+            writeHistogram(writer, name, "", h);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Frame::COUNT); ++i) {
+            _parseTime[i].snapshot(h);
+            writeHistogram(writer, "parse_us.", frameNames[i], h);
+        }
+        _heartbeatRoundTrip.snapshot(h);
+        writeHistogram(writer, "heartbeat_ms", "", h);
+        _tlsHandshake.snapshot(h);
+        writeHistogram(writer, "tls_ms", "", h);
+        _recoveryTime.snapshot(h);
+        writeHistogram(writer, "recovery_ms", "", h);
+
+        char line[64];
+        for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); ++i) {
+            int n = snprintf(line, sizeof(line), "c %s %u\n", counterNames[i],
+                static_cast<unsigned>(_counters[i].load(std::memory_order_relaxed)));
+            if (n > 0) writer(line, n);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(Gauge::COUNT); ++i) {
+            int n = snprintf(line, sizeof(line), "g %s %u %u\n", gaugeNames[i],
+                static_cast<unsigned>(_gauges[i].load(std::memory_order_relaxed)),
+                static_cast<unsigned>(_gaugeHighs[i].load(std::memory_order_relaxed)));
+            if (n > 0) writer(line, n);
+        }
+    }
+
+    void Metrics::exportText(Print& out) const {
+        PrintWriter writer { out };
+        writeText(writer);
+    }
+
+    size_t Metrics::exportText(char* buffer, size_t size) const {
+        BufferWriter writer { buffer, size, 0 };
+        if (size > 0) buffer[0] = '\0';
+        writeText(writer);
+        return writer.length;
+    }
+
+    uint32_t Metrics::bucketBound(size_t bucket) {
+        return bucket < DISCORD_METRICS_BUCKETS - 1 ? bucketBounds[bucket] : UINT32_MAX;
+    }
+
+    Metrics::Route Metrics::classify(const char* uri) {
+        if (strstr(uri, "/interactions/")) return Route::InteractionCallback;
+        if (strstr(uri, "/commands")) return Route::ApplicationCommands;
+        if (strstr(uri, "/gateway")) return Route::Gateway;
+        if (strstr(uri, "/channels/")) return Route::ChannelMessages;
+        if (strstr(uri, "/webhooks/")) return Route::Webhooks;
+        return Route::Other;
+    }
+}
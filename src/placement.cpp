@@ -0,0 +1,146 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <placement.h>
+
+#include <atomic>
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+namespace Discord {
+    namespace {
+        // Precedes every buffer, 8 bytes to keep the buffer itself 8-byte aligned.
+        struct Header {
+            uint32_t size;
+            uint8_t region;
+            uint8_t reserved[3];
+        };
+
+        struct RegionCounters {
+            std::atomic<uint32_t> bytes;
+            std::atomic<uint32_t> highest;
+            std::atomic<uint32_t> allocations;
+            std::atomic<uint32_t> fallbacks;
+        };
+
+        std::atomic<uint8_t> currentPlacement { static_cast<uint8_t>(DISCORD_PLACEMENT) };
+        RegionCounters counters[static_cast<size_t>(MemoryRegion::COUNT)];
+
+        Header* headerOf(const void* ptr) {
+            return reinterpret_cast<Header*>(const_cast<uint8_t*>(static_cast<const uint8_t*>(ptr))) - 1;
+        }
+
+        void account(MemoryRegion region, uint32_t size) {
+            RegionCounters& c = counters[static_cast<size_t>(region)];
+            uint32_t bytes = c.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+            uint32_t previous = c.highest.load(std::memory_order_relaxed);
+            while (bytes > previous && !c.highest.compare_exchange_weak(previous, bytes, std::memory_order_relaxed)) {}
+        }
+
+        void* rawAllocate(size_t size, MemoryRegion wanted, MemoryRegion& got) {
+#ifdef ESP32
+            if (wanted == MemoryRegion::Psram) {
+                void* memory = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                if (memory) {
+                    got = MemoryRegion::Psram;
+                    return memory;
+                }
+                counters[static_cast<size_t>(MemoryRegion::Psram)].fallbacks.fetch_add(1, std::memory_order_relaxed);
+            }
+            got = MemoryRegion::Internal;
+            return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+            // Host stand-in: one heap, tagged with the region the policy asked for.
+            got = wanted;
+            return malloc(size);
+#endif
+        }
+
+        void rawFree(void* memory) {
+#ifdef ESP32
+            heap_caps_free(memory);
+#else
+            free(memory);
+#endif
+        }
+    }
+
+    void setPlacement(Placement placement) {
+        currentPlacement.store(static_cast<uint8_t>(placement), std::memory_order_relaxed);
+    }
+
+    Placement placement() {
+        return static_cast<Placement>(currentPlacement.load(std::memory_order_relaxed));
+    }
+
+    MemoryRegion preferredRegion(BufferKind kind) {
+        switch (placement()) {
+            case Placement::AllInPsram:
+                return MemoryRegion::Psram;
+            case Placement::ColdInPsram:
+                return kind == BufferKind::GatewayFrame ? MemoryRegion::Internal : MemoryRegion::Psram;
+            default:
+                return MemoryRegion::Internal;
+        }
+    }
+
+    void* allocate(size_t size, BufferKind kind) {
+        if (size > UINT32_MAX - sizeof(Header)) return nullptr;
+        MemoryRegion region;
+        Header* header = static_cast<Header*>(rawAllocate(size + sizeof(Header), preferredRegion(kind), region));
+        if (!header) return nullptr;
+        header->size = size + sizeof(Header);
+        header->region = static_cast<uint8_t>(region);
+        account(region, header->size);
+        return header + 1;
+    }
+
+    void* reallocate(void* ptr, size_t size, BufferKind kind) {
+        if (!ptr) return allocate(size, kind);
+        void* resized = allocate(size, kind);
+        if (!resized) return nullptr;
+        size_t kept = headerOf(ptr)->size - sizeof(Header);
+        memcpy(resized, ptr, kept < size ? kept : size);
+        release(ptr);
+        return resized;
+    }
+
+    void release(void* ptr) {
+        if (!ptr) return;
+        Header* header = headerOf(ptr);
+        counters[header->region].bytes.fetch_sub(header->size, std::memory_order_relaxed);
+        rawFree(header);
+    }
+
+    MemoryRegion regionOf(const void* ptr) {
+        return static_cast<MemoryRegion>(headerOf(ptr)->region);
+    }
+
+    MemoryStats memoryStats(MemoryRegion region) {
+        const RegionCounters& c = counters[static_cast<size_t>(region)];
+        MemoryStats stats;
+        stats.bytes = c.bytes.load(std::memory_order_relaxed);
+        stats.highest = c.highest.load(std::memory_order_relaxed);
+        stats.allocations = c.allocations.load(std::memory_order_relaxed);
+        stats.fallbacks = c.fallbacks.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
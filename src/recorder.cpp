@@ -0,0 +1,199 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <recorder.h>
+
+namespace Discord {
+    FlightRecorder::FlightRecorder() : _task { nullptr }, _running { false }, _recorded { 0 }, _dropped { 0 } {}
+
+    FlightRecorder::~FlightRecorder() {
+        end();
+    }
+
+    bool FlightRecorder::begin(fs::FS& fs, const char* path, size_t maxFileSize) {
+        if (_running || strlen(path) > DISCORD_RECORDER_PATH_LENGTH) return false;
+        {
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            _fs = &fs;
+            strcpy(_path, path);
+            strcpy(_oldPath, path);
+            strcat(_oldPath, ".old");
+            _maxFileSize = maxFileSize;
+            _file = fs.open(_path, "a");
+            if (!_file) return false;
+            _fileSize = _file.size();
+        }
+
+        _running = true;
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate(flushTask, "DiscordRecorder", DISCORD_RECORDER_TASK_STACK, this, tskIDLE_PRIORITY + 1, &task) != pdPASS) {
+            _running = false;
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            _file.close();
+            return false;
+        }
+        // The task only clears _task once _running is false, so this cannot overwrite its exit.
+        _task = task;
+        return true;
+    }
+
+    void FlightRecorder::end() {
+        if (!_running) return;
+        _running = false;
+        // The task flushes once more and clears _task before deleting itself.
+        TaskHandle_t task = _task;
+        if (task) {
+            xTaskNotifyGive(task);
+            while (_task) {
+                delay(1);
+            }
+        }
+        flush();
+        std::lock_guard<std::mutex> lock(_writeMtx);
+        _file.close();
+    }
+
+    bool FlightRecorder::record(Direction direction, uint8_t opcode, const uint8_t* payload, size_t length,
+        uint32_t timestamp) {
+        if (!_running) return false;
+        // Identify and Resume hold the bot token, which must never end up in a file pulled off the device.
+        bool redacted = direction == Direction::Sent && (opcode == 2 || opcode == 6);
+        if (redacted) length = 0;
+        bool truncated = length > DISCORD_RECORDER_MAX_PAYLOAD;
+        if (truncated) length = DISCORD_RECORDER_MAX_PAYLOAD;
+
+        uint8_t header[HEADER_SIZE] = {
+            MAGIC,
+            static_cast<uint8_t>(static_cast<uint8_t>(direction) | (redacted ? REDACTED : 0) |
+                (truncated ? TRUNCATED : 0)),
+            opcode,
+            0,
+            static_cast<uint8_t>(timestamp),
+            static_cast<uint8_t>(timestamp >> 8),
+            static_cast<uint8_t>(timestamp >> 16),
+            static_cast<uint8_t>(timestamp >> 24),
+            static_cast<uint8_t>(length),
+            static_cast<uint8_t>(length >> 8)
+        };
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (_used + HEADER_SIZE + length > DISCORD_RECORDER_BUFFER) {
+                ++_dropped;
+                return false;
+            }
+            append(header, HEADER_SIZE);
+            append(payload, length);
+            wake = _used > DISCORD_RECORDER_BUFFER / 2;
+        }
+        ++_recorded;
+        TaskHandle_t task = _task;
+        if (wake && task) {
+            xTaskNotifyGive(task);
+        }
+        return true;
+    }
+
+    size_t FlightRecorder::flush() {
+        std::lock_guard<std::mutex> lock(_writeMtx);
+        size_t written = 0;
+        size_t length;
+        while ((length = take(_batch, sizeof(_batch))) > 0) {
+            if (_fileSize + length > _maxFileSize) {
+                rotate();
+            }
+            if (!_file) break;
+            _file.write(_batch, length);
+            _fileSize += length;
+            written += length;
+        }
+        if (written > 0 && _file) {
+            _file.flush();
+        }
+        return written;
+    }
+
+    void FlightRecorder::flushTask(void* parameter) {
+        FlightRecorder* recorder = static_cast<FlightRecorder*>(parameter);
+        while (recorder->_running) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISCORD_RECORDER_FLUSH_INTERVAL));
+            recorder->flush();
+        }
+        recorder->_task = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    size_t FlightRecorder::take(uint8_t* out, size_t size) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        size_t taken = 0;
+        while (_used - taken >= HEADER_SIZE) {
+            uint8_t lengthBytes[2];
+            copyOut(taken + 8, lengthBytes, 2);
+            size_t recordSize = HEADER_SIZE + (lengthBytes[0] | lengthBytes[1] << 8);
+            if (taken + recordSize > size) break;
+            copyOut(taken, out + taken, recordSize);
+            taken += recordSize;
+        }
+        _head = (_head + taken) % DISCORD_RECORDER_BUFFER;
+        _used -= taken;
+        return taken;
+    }
+
+    void FlightRecorder::copyOut(size_t from, uint8_t* out, size_t length) const {
+        size_t start = (_head + from) % DISCORD_RECORDER_BUFFER;
+        size_t first = DISCORD_RECORDER_BUFFER - start;
+        if (first > length) first = length;
+        memcpy(out, _ring + start, first);
+        memcpy(out + first, _ring, length - first);
+    }
+
+    void FlightRecorder::append(const uint8_t* data, size_t length) {
+        size_t tail = (_head + _used) % DISCORD_RECORDER_BUFFER;
+        size_t first = DISCORD_RECORDER_BUFFER - tail;
+        if (first > length) first = length;
+        memcpy(_ring + tail, data, first);
+        memcpy(_ring, data + first, length - first);
+        _used += length;
+    }
+
+    void FlightRecorder::rotate() {
+        _file.close();
+        _fs->remove(_oldPath);
+        _fs->rename(_path, _oldPath);
+        _file = _fs->open(_path, "w");
+        _fileSize = 0;
+    }
+
+    bool FlightRecorder::read(const uint8_t* data, size_t length, size_t& offset, Record& out) {
+        if (offset + HEADER_SIZE > length || data[offset] != MAGIC) return false;
+        const uint8_t* header = data + offset;
+        size_t payloadLength = header[8] | header[9] << 8;
+        if (offset + HEADER_SIZE + payloadLength > length) return false;
+        out.direction = static_cast<Direction>(header[1] & 0x01);
+        out.truncated = (header[1] & TRUNCATED) != 0;
+        out.redacted = (header[1] & REDACTED) != 0;
+        out.opcode = header[2];
+        out.timestamp = static_cast<uint32_t>(header[4]) | static_cast<uint32_t>(header[5]) << 8 |
+            static_cast<uint32_t>(header[6]) << 16 | static_cast<uint32_t>(header[7]) << 24;
+        out.payload = header + HEADER_SIZE;
+        out.length = payloadLength;
+        offset += HEADER_SIZE + payloadLength;
+        return true;
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <rest.h>
+
+#ifndef DISCORD_HOST
+#define DISCORD_HOST "https://discord.com"
+#endif
+
+namespace Discord {
+    void RestClient::begin() {
+        if (_begun) return;
+        // Same as passing no CA certificate to HTTPClient, which then skips verification.
+        _tls.setInsecure();
+        // HTTPClient only drives the connection, opening it is left to connect() so handshakes can be measured.
+        _https.setReuse(true);
+        _https.begin(_tls, DISCORD_HOST);
+        static const char* rateLimitHeaders[] = { "X-RateLimit-Remaining", "X-RateLimit-Reset-After" };
+        _https.collectHeaders(rateLimitHeaders, 2);
+        _begun = true;
+    }
+
+    void RestClient::end() {
+        _https.end();
+        _tls.stop();
+        _begun = false;
+    }
+
+    bool RestClient::connect(Metrics* metrics) {
+        // Unread bytes mean the connection is still open even if the peer has started to close it.
+        if (_tls.connected() || _tls.available() > 0) {
+            if (metrics) metrics->increment(Metrics::Counter::RestConnectionsReused);
+            return true;
+        }
+
+        unsigned long start = millis();
+        bool connected = _tls.connect(DISCORD_REST_HOST, 443);
+        ++_handshakes;
+        if (metrics) {
+            metrics->tlsHandshake().record(millis() - start);
+            metrics->increment(Metrics::Counter::TlsHandshakes);
+        }
+        return connected;
+    }
+
+    bool RestScheduler::acquire(unsigned long deadline, RestPriority priority) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        size_t slot;
+        while ((slot = freeSlot()) == DISCORD_REST_SCHEDULER_SLOTS) {
+            _changed.wait(lock);
+        }
+        Waiter& waiter = _waiters[slot];
+        waiter.deadline = deadline;
+        waiter.priority = priority;
+        waiter.ticket = _nextTicket++;
+        waiter.used = true;
+
+        while (_busy || !first(slot)) {
+            _changed.wait(lock);
+        }
+        waiter.used = false;
+        _busy = true;
+        // Freeing the slot may let a request waiting for one in.
+        _changed.notify_all();
+        return static_cast<long>(millis() - deadline) > 0;
+    }
+
+    void RestScheduler::release() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _busy = false;
+        _changed.notify_all();
+    }
+
+    unsigned long RestScheduler::deadline(RestPriority priority, unsigned long since) {
+        switch (priority) {
+            case RestPriority::Interaction:
+                return since + DISCORD_INTERACTION_DEADLINE;
+            case RestPriority::Message:
+                return since + DISCORD_MESSAGE_DEADLINE;
+            default:
+                return since + DISCORD_BULK_DEADLINE;
+        }
+    }
+
+    size_t RestScheduler::waiting() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        size_t count = 0;
+        for (size_t i = 0; i < DISCORD_REST_SCHEDULER_SLOTS; ++i) {
+            if (_waiters[i].used) ++count;
+        }
+        return count;
+    }
+
+    bool RestScheduler::first(size_t slot) const {
+        const Waiter& self = _waiters[slot];
+        for (size_t i = 0; i < DISCORD_REST_SCHEDULER_SLOTS; ++i) {
+            const Waiter& other = _waiters[i];
+            if (i == slot || !other.used) continue;
+            // Compare by difference so the order survives millis() wrapping around.
+            long byDeadline = static_cast<long>(other.deadline - self.deadline);
+            if (byDeadline < 0) return false;
+            if (byDeadline > 0) continue;
+            if (other.priority < self.priority) return false;
+            if (other.priority == self.priority && static_cast<int32_t>(other.ticket - self.ticket) < 0) return false;
+        }
+        return true;
+    }
+
+    size_t RestScheduler::freeSlot() const {
+        for (size_t i = 0; i < DISCORD_REST_SCHEDULER_SLOTS; ++i) {
+            if (!_waiters[i].used) return i;
+        }
+        return DISCORD_REST_SCHEDULER_SLOTS;
+    }
+
+    bool RestClient::rateLimited(uint64_t key) {
+        std::lock_guard<std::mutex> lock(_rateLimitMtx);
+        for (size_t i = 0; i < DISCORD_RATE_LIMIT_BUCKETS; ++i) {
+            RateLimitBucket& bucket = _rateLimits[i];
+            if (bucket.key == key) {
+                return bucket.remaining == 0 && static_cast<long>(millis() - bucket.resetAt) < 0;
+            }
+        }
+        return false;
+    }
+
+    void RestClient::updateRateLimit(uint64_t key, int httpResponseCode) {
+        String remaining = _https.header("X-RateLimit-Remaining");
+        String resetAfter = _https.header("X-RateLimit-Reset-After");
+        if (remaining.isEmpty() && httpResponseCode != HTTP_CODE_TOO_MANY_REQUESTS) return;
+
+        unsigned long now = millis();
+        std::lock_guard<std::mutex> lock(_rateLimitMtx);
+        // Reuse this key's bucket, otherwise the one that expired the longest time ago.
+        RateLimitBucket* target = &_rateLimits[0];
+        for (size_t i = 0; i < DISCORD_RATE_LIMIT_BUCKETS; ++i) {
+            RateLimitBucket& bucket = _rateLimits[i];
+            if (bucket.key == key) {
+                target = &bucket;
+                break;
+            }
+            if (static_cast<long>(bucket.resetAt - target->resetAt) < 0) {
+                target = &bucket;
+            }
+        }
+        target->key = key;
+        target->remaining = httpResponseCode == HTTP_CODE_TOO_MANY_REQUESTS ? 0 : remaining.toInt();
+        // Reset-After is in seconds with millisecond precision, e.g. "1.337".
+        target->resetAt = now + static_cast<unsigned long>(atof(resetAfter.c_str()) * 1000);
+    }
+
+    bool RestClient::claimIdentify(unsigned long now) {
+        std::lock_guard<std::mutex> lock(_identifyMtx);
+        if (_identified && now - _lastIdentify < DISCORD_IDENTIFY_INTERVAL) return false;
+        _identified = true;
+        _lastIdentify = now;
+        return true;
+    }
+}
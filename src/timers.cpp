@@ -0,0 +1,194 @@
+/*
+ * ESP32-DiscordBot v0.1
+ * Copyright (C) 2023  Neo Ting Wei Terrence
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <timers.h>
+
+namespace Discord {
+    TimerWheel::TimerWheel() {
+        memset(_slots, 0, sizeof(_slots));
+        memset(_occupied, 0, sizeof(_occupied));
+    }
+
+    void TimerWheel::schedule(Timer& timer, unsigned long now, unsigned long delay) {
+        if (timer._armed) unlink(timer);
+        // With nothing scheduled the wheel's position means nothing, so catch it up instead of walking there later.
+        if (_count == 0) _current = now;
+        timer._deadline = static_cast<uint32_t>(now + delay);
+        timer._fired = false;
+        insert(timer);
+    }
+
+    void TimerWheel::cancel(Timer& timer) {
+        if (timer._armed) unlink(timer);
+        timer._fired = false;
+    }
+
+    bool TimerWheel::fired(Timer& timer) {
+        bool fired = timer._fired;
+        timer._fired = false;
+        return fired;
+    }
+
+    void TimerWheel::insert(Timer& timer) {
+        int32_t delta = static_cast<int32_t>(timer._deadline - _current);
+        uint32_t tick = timer._deadline;
+        uint8_t level = 0;
+        if (delta <= 0) {
+            // Already due. The current tick has been processed, so the next one is the earliest it can fire.
+            tick = _current + 1;
+        }
+        else {
+            while (level < LEVELS - 1 && static_cast<uint32_t>(delta) >= (1UL << ((level + 1) * SLOT_BITS))) {
+                ++level;
+            }
+            // Past the top level's range, park it in the furthest slot. It is placed again when that slot cascades.
+            if (level == LEVELS - 1 && static_cast<uint32_t>(delta) >= (1UL << (LEVELS * SLOT_BITS))) {
+                tick = _current + (1UL << (LEVELS * SLOT_BITS)) - 1;
+            }
+        }
+
+        uint8_t slot = slotOf(tick, level);
+        timer._level = level;
+        timer._slot = slot;
+        timer._prev = nullptr;
+        timer._next = _slots[level][slot];
+        if (timer._next) timer._next->_prev = &timer;
+        _slots[level][slot] = &timer;
+        _occupied[level] |= 1ULL << slot;
+        timer._armed = true;
+        ++_count;
+    }
+
+    void TimerWheel::unlink(Timer& timer) {
+        if (timer._prev) {
+            timer._prev->_next = timer._next;
+        }
+        else {
+            _slots[timer._level][timer._slot] = timer._next;
+        }
+        if (timer._next) timer._next->_prev = timer._prev;
+        if (!_slots[timer._level][timer._slot]) {
+            _occupied[timer._level] &= ~(1ULL << timer._slot);
+        }
+        timer._next = nullptr;
+        timer._prev = nullptr;
+        timer._armed = false;
+        --_count;
+    }
+
+    void TimerWheel::cascade(uint8_t level, uint8_t slot) {
+        Timer* timer = _slots[level][slot];
+        _slots[level][slot] = nullptr;
+        _occupied[level] &= ~(1ULL << slot);
+        while (timer) {
+            Timer* next = timer->_next;
+            timer->_next = nullptr;
+            timer->_prev = nullptr;
+            timer->_armed = false;
+            --_count;
+            if (static_cast<int32_t>(timer->_deadline - _current) <= 0) {
+                // Due on this very tick.
+                timer->_fired = true;
+            }
+            else {
+                insert(*timer);
+            }
+            timer = next;
+        }
+    }
+
+    void TimerWheel::expire(uint8_t slot) {
+        Timer* timer = _slots[0][slot];
+        _slots[0][slot] = nullptr;
+        _occupied[0] &= ~(1ULL << slot);
+        while (timer) {
+            Timer* next = timer->_next;
+            timer->_next = nullptr;
+            timer->_prev = nullptr;
+            timer->_armed = false;
+            timer->_fired = true;
+            --_count;
+            timer = next;
+        }
+    }
+
+    void TimerWheel::advance(unsigned long now) {
+        uint32_t target = static_cast<uint32_t>(now);
+        while (static_cast<int32_t>(target - _current) > 0) {
+            if (_count == 0) {
+                _current = target;
+                return;
+            }
+            // The next tick with work is the next one if level 0 holds timers, otherwise the next time the lowest
+            // occupied level cascades.
+            uint32_t next = _current + 1;
+            if (_occupied[0] == 0) {
+                uint8_t level = 1;
+                while (_occupied[level] == 0) ++level;
+                uint8_t shift = level * SLOT_BITS;
+                next = ((_current >> shift) + 1) << shift;
+                if (static_cast<int32_t>(target - next) < 0) {
+                    _current = target;
+                    return;
+                }
+            }
+            _current = next;
+
+            // Cascade before expiring, so a timer brought down into this tick's level 0 slot fires now.
+            for (uint8_t level = 1; level < LEVELS; ++level) {
+                if (slotOf(_current, level - 1) != 0) break;
+                cascade(level, slotOf(_current, level));
+            }
+            expire(slotOf(_current, 0));
+        }
+    }
+
+    unsigned long TimerWheel::nextDeadline() const {
+        if (_count == 0) return NONE;
+        unsigned long earliest = NONE;
+        for (uint8_t level = 0; level < LEVELS; ++level) {
+            uint64_t bits = _occupied[level];
+            if (bits == 0) continue;
+            // Slots in time order start right after the current one, the current one itself comes round last.
+            uint8_t start = (slotOf(_current, level) + 1) & (SLOTS - 1);
+            uint64_t rotated = start == 0 ? bits : (bits >> start) | (bits << (SLOTS - start));
+            uint8_t slot = (start + __builtin_ctzll(rotated)) & (SLOTS - 1);
+
+            unsigned long wait;
+            if (level == 0) {
+                // A level 0 slot holds exactly one tick, timers that were already due included.
+                wait = __builtin_ctzll(rotated) + 1;
+            }
+            else {
+                // Slots further on hold later deadlines, except on the top level where timers beyond its range
+                // are parked in whatever slot is furthest at the time. Look through all of it.
+                wait = NONE;
+                for (uint8_t i = slot; ; i = (i + 1) & (SLOTS - 1)) {
+                    for (const Timer* timer = _slots[level][i]; timer; timer = timer->_next) {
+                        int32_t delta = static_cast<int32_t>(timer->_deadline - _current);
+                        unsigned long until = delta > 0 ? delta : 1;
+                        if (until < wait) wait = until;
+                    }
+                    if (level < LEVELS - 1 || ((i + 1) & (SLOTS - 1)) == slot) break;
+                }
+            }
+            if (wait < earliest) earliest = wait;
+        }
+        return earliest;
+    }
+}